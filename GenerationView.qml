@@ -5,7 +5,7 @@ import QtQuick.Layouts 1.2
 Item {
     id: generationWindow
     visible: true
-    width: 295
+    width: 615
     height: 250
 
     TableView
@@ -24,6 +24,38 @@ Item {
                 horizontalAlignment: Text.AlignHCenter
         }
 
+        TableViewColumn {
+                role: "meanMoveTime"
+                title: "Mean us"
+                width: 70
+                horizontalAlignment: Text.AlignRight
+                delegate: Text {text: styleData.value ? styleData.value.toFixed(2) : ""}
+        }
+
+        TableViewColumn {
+                role: "p50MoveTime"
+                title: "p50 us"
+                width: 70
+                horizontalAlignment: Text.AlignRight
+                delegate: Text {text: styleData.value ? styleData.value.toFixed(2) : ""}
+        }
+
+        TableViewColumn {
+                role: "p99MoveTime"
+                title: "p99 us"
+                width: 70
+                horizontalAlignment: Text.AlignRight
+                delegate: Text {text: styleData.value ? styleData.value.toFixed(2) : ""}
+        }
+
+        TableViewColumn {
+                role: "generationTime"
+                title: "Gen ms"
+                width: 110
+                horizontalAlignment: Text.AlignRight
+                delegate: Text {text: styleData.value ? styleData.value.toFixed(1) : ""}
+        }
+
         model: wormTankModelView.generationList
     }
 }
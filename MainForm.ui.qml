@@ -27,6 +27,9 @@ Item {
         y: 80
         width: 400
         height: 400
+        fillMode: Image.PreserveAspectFit
+        sourceSize.width: 400
+        sourceSize.height: 400
         source: "image://wormtankframe/" + wormTank.tick
 
         Rectangle {
@@ -0,0 +1,36 @@
+import QtQuick 2.0
+import QtQuick.Controls 1.4
+import QtQuick.Layouts 1.2
+
+Item {
+    id: memoryWindow
+    visible: true
+    width: 290
+    height: 310
+
+    TableView
+    {
+        anchors.fill: parent
+        TableViewColumn {
+                role: "name"
+                title: "Area"
+                width: 130
+            }
+
+        TableViewColumn {
+                role: "kBytes"
+                title: "KB"
+                width: 70
+                horizontalAlignment: Text.AlignRight
+        }
+
+        TableViewColumn {
+                role: "peakKBytes"
+                title: "Peak KB"
+                width: 70
+                horizontalAlignment: Text.AlignRight
+        }
+
+        model: wormTank.memoryUsage
+    }
+}
@@ -7,13 +7,15 @@ Window {
     modality: "ApplicationModal"
     title: qsTr("Start a new worm tank")
     width: 400
-    height: 150
+    height: 270
 
     StartTankForm
     {
         id: startForm
         wormTypes.model: wormTankModelView.wormTypes
         okButton.onClicked: {
+            wormTankModelView.setNewTankSettings(tankWidth.value, tankHeight.value, worms.value,
+                                                 food.value, survivors.value, tileSize.value, stagnantTicks.value);
             wormTankModelView.start(wormTypes.currentText, reset.checked);
             startWindow.destroy();
         }
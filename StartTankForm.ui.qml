@@ -7,8 +7,15 @@ Item {
     property alias okButton: okButton
     property alias cancelButton: cancelButton
     property alias reset: reset
+    property alias tankWidth: tankWidth
+    property alias tankHeight: tankHeight
+    property alias worms: worms
+    property alias food: food
+    property alias survivors: survivors
+    property alias tileSize: tileSize
+    property alias stagnantTicks: stagnantTicks
     width: 400
-    height: 140
+    height: 260
 
 
     GridLayout {
@@ -16,9 +23,9 @@ Item {
         x: 8
         y: 0
         width: 378
-        height: 130
-        columns: 3
-        rows: 3
+        height: 250
+        columns: 4
+        rows: 7
 
         Text {
             id: text1
@@ -32,31 +39,140 @@ Item {
             height: 22
             activeFocusOnPress: true
             Layout.column: 1
-            Layout.columnSpan: 2
+            Layout.columnSpan: 3
             Layout.fillWidth: true
         }
 
         CheckBox {
             id: reset
             text: qsTr("Reset to First Generation")
+            Layout.row: 1
+            Layout.columnSpan: 4
+        }
+
+        Text {
+            text: qsTr("Width")
+            font.pixelSize: 12
+            Layout.row: 2
+        }
+
+        SpinBox {
+            id: tankWidth
+            minimumValue: 50
+            maximumValue: 4096
+            value: 200
+            Layout.row: 2
+            Layout.column: 1
+        }
+
+        Text {
+            text: qsTr("Height")
+            font.pixelSize: 12
+            Layout.row: 2
+            Layout.column: 2
+        }
+
+        SpinBox {
+            id: tankHeight
+            minimumValue: 50
+            maximumValue: 4096
+            value: 200
+            Layout.row: 2
+            Layout.column: 3
+        }
+
+        Text {
+            text: qsTr("Worms")
+            font.pixelSize: 12
+            Layout.row: 3
+        }
+
+        SpinBox {
+            id: worms
+            minimumValue: 2
+            maximumValue: 100000
+            value: 100
+            Layout.row: 3
+            Layout.column: 1
+        }
+
+        Text {
+            text: qsTr("Food")
+            font.pixelSize: 12
+            Layout.row: 3
+            Layout.column: 2
+        }
+
+        SpinBox {
+            id: food
+            minimumValue: 0
+            maximumValue: 4000000
+            value: 400
+            Layout.row: 3
+            Layout.column: 3
+        }
+
+        Text {
+            text: qsTr("Survivors")
+            font.pixelSize: 12
+            Layout.row: 4
+        }
+
+        SpinBox {
+            id: survivors
+            minimumValue: 1
+            maximumValue: 50000
+            value: 10
+            Layout.row: 4
+            Layout.column: 1
+        }
+
+        Text {
+            text: qsTr("Tile size")
+            font.pixelSize: 12
+            Layout.row: 4
+            Layout.column: 2
+        }
+
+        SpinBox {
+            id: tileSize
+            minimumValue: 0
+            maximumValue: 4096
+            value: 0
+            Layout.row: 4
+            Layout.column: 3
+        }
+
+        Text {
+            text: qsTr("Stagnant ticks")
+            font.pixelSize: 12
+            Layout.row: 5
+        }
+
+        SpinBox {
+            id: stagnantTicks
+            minimumValue: 0
+            maximumValue: 100000
+            value: 0
+            Layout.row: 5
+            Layout.column: 1
         }
 
         Button {
             id: cancelButton
             text: qsTr("Cancel")
-            Layout.column: 1
-            Layout.row: 2
+            Layout.column: 2
+            Layout.row: 6
         }
 
         Button {
             id: okButton
             text: qsTr("OK")
             isDefault: true
-            Layout.column: 2
-            Layout.row: 2
+            Layout.column: 3
+            Layout.row: 6
         }
 
 
     }
 }
-
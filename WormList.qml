@@ -5,7 +5,7 @@ import QtQuick.Controls 1.4
 Item {
     id: wormListWindow
     visible: true
-    width: 500
+    width: 640
     height: 150
 
     TableView
@@ -41,6 +41,20 @@ Item {
             width: 60
         }
 
+        TableViewColumn {
+            role: "meanMoveTime"
+            title: "Mean us"
+            width: 70
+            delegate: Text {text: styleData.value ? styleData.value.toFixed(2) : ""}
+        }
+
+        TableViewColumn {
+            role: "p99MoveTime"
+            title: "p99 us"
+            width: 70
+            delegate: Text {text: styleData.value ? styleData.value.toFixed(2) : ""}
+        }
+
         model: worms
         anchors.fill: parent
     }
@@ -8,7 +8,6 @@ SOURCES += main.cpp \
     brain.cpp \
     randombrain.cpp \
     simplebrain.cpp \
-    braincell.cpp \
     iobrain.cpp \
     simplewithnexttobrain.cpp \
     wormtankmodelview.cpp \
@@ -25,7 +24,18 @@ SOURCES += main.cpp \
     history.cpp \
     trendchart.cpp \
     beambrain.cpp \
-    genlist.cpp
+    genlist.cpp \
+    quadtree.cpp \
+    distancefield.cpp \
+    genome.cpp \
+    hiddenlayerbrain.cpp \
+    memorypool.cpp \
+    movecost.cpp \
+    memoryusage.cpp \
+    tanksettings.cpp \
+    benchmark.cpp \
+    tanktiles.cpp \
+    tankgrid.cpp
 
 RESOURCES += qml.qrc
 
@@ -41,7 +51,6 @@ HEADERS += \
     brain.h \
     randombrain.h \
     simplebrain.h \
-    braincell.h \
     iobrain.h \
     simplewithnexttobrain.h \
     direction.h \
@@ -63,7 +72,19 @@ HEADERS += \
     history.h \
     trendchart.h \
     beambrain.h \
-    genlist.h
+    genlist.h \
+    quadtree.h \
+    distancefield.h \
+    genome.h \
+    hiddenlayerbrain.h \
+    memorypool.h \
+    movecost.h \
+    wormbody.h \
+    memoryusage.h \
+    tanksettings.h \
+    benchmark.h \
+    tanktiles.h \
+    tankgrid.h
 
 CONFIG += c++11
 
@@ -8,6 +8,17 @@ BrainCreator<BeamBrain> g_beamBrainCreator(
         "Sends out beams in three directions to detect nearest of food, worm or wall"
         );
 
+/**
+ * @brief Construct a new brain with random weights
+ * @param worm worm to attach the brain to
+ */
+BeamBrain::BeamBrain(Worm *worm) : IOBrain(worm, 12)
+{
+    addSensorGroup(4, 1);
+    addSensorGroup(4, 1);
+    addSensorGroup(4, 1);
+}
+
 /**
  * @brief Return the name of this brain type
  * @return name of brain type
@@ -28,13 +39,23 @@ Brain *BeamBrain::clone(Worm *worm)
 }
 
 /**
- * @brief Fill the inputs with the food seen sensor data
+ * @brief Fill the inputs for one of the sensors
+ * @param group sensor group to fill
  * @param pt worm head position
  * @param dir directin worm is facing
  */
-void BeamBrain::fillInputs(QPoint pt, int dir)
+void BeamBrain::fillSensorGroup(uint group, QPoint pt, int dir)
 {
-    m_worm->tank()->foodBeam(pt, dir, m_inputs);
-    m_worm->tank()->wormBeam(pt, dir, m_inputs+4);
-    m_worm->tank()->wallBeam(pt, dir, m_inputs+8);
+    switch (group)
+    {
+    case 0:
+        m_worm->tank()->foodBeam(pt, dir, m_inputs);
+        break;
+    case 1:
+        m_worm->tank()->wormBeam(pt, dir, m_inputs+4);
+        break;
+    case 2:
+        m_worm->tank()->wallBeam(pt, dir, m_inputs+8);
+        break;
+    }
 }
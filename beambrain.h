@@ -9,7 +9,7 @@
 class BeamBrain : public IOBrain
 {
 public:
-    BeamBrain(Worm *worm) : IOBrain(worm,12) {}
+    BeamBrain(Worm *worm);
     BeamBrain(const BeamBrain &other, Worm *worm) : IOBrain(other, worm) {}
     virtual ~BeamBrain(){}
 
@@ -17,7 +17,7 @@ public:
     virtual Brain *clone(Worm *worm);
 
 protected:
-    virtual void fillInputs(QPoint pt, int dir);
+    virtual void fillSensorGroup(uint group, QPoint pt, int dir);
 };
 
 #endif // BEAMBRAIN_H
@@ -0,0 +1,99 @@
+#include "benchmark.h"
+#include "wormtank.h"
+#include "genome.h"
+#include <QElapsedTimer>
+#include <cstdlib>
+
+Benchmark::Benchmark(QString wormType) :
+    m_wormType(wormType),
+    m_out(stdout)
+{
+}
+
+/**
+ * @brief Run the tanks and print the results
+ * @return exit code for the application
+ */
+int Benchmark::run()
+{
+    if (BrainFactory::instance()->creators().count(m_wormType.toStdString()) == 0)
+    {
+        m_out << "Unknown worm type " << m_wormType << "\n";
+        return 1;
+    }
+
+    m_out << "Benchmark of " << m_wormType << " worms\n";
+    m_out << "Width\tHeight\tWorms\tFood\tTile\tTicks/s\tGenerations\tKBytes\tPeak KBytes\n";
+
+    // Same start every time so runs can be compared
+    std::srand(1);
+    seedGenomeRandom(1);
+
+    TankSettings settings;
+    for (int size : {200, 512, 1024, 2048, 4096})
+    {
+        settings.width = settings.height = size;
+        runTank(settings);
+    }
+
+    // Keep the default amount of food per worm
+    for (uint worms : {1000u, 10000u, 100000u})
+    {
+        settings.startWorms = worms;
+        settings.startFood = worms * 4;
+        runTank(settings);
+    }
+
+    settings = TankSettings();
+    settings.width = settings.height = TankSettings::MaxSize;
+    for (uint food : {4000u, 40000u, 400000u})
+    {
+        settings.startFood = food;
+        runTank(settings);
+    }
+
+    // Plan the moves on all the cores
+    settings = TankSettings();
+    settings.width = settings.height = TankSettings::MaxSize;
+    settings.startWorms = 10000;
+    settings.startFood = 40000;
+    for (int tileSize : {0, 2048, 1024, 512, 256})
+    {
+        settings.tileSize = tileSize;
+        runTank(settings);
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Run a new tank for at least MinMsecs and MinTicks and print its speed
+ * @param settings size and population of the tank
+ */
+void Benchmark::runTank(const TankSettings &settings)
+{
+    WormTank tank;
+    tank.setNewTankSettings(settings);
+    tank.start(m_wormType, true);
+    TankSettings used = tank.settings();
+
+    uint ticks = 0;
+    uint firstGeneration = tank.generation();
+    QElapsedTimer timer;
+    timer.start();
+    while (timer.elapsed() < MinMsecs || ticks < MinTicks)
+    {
+        tank.step();
+        ticks++;
+    }
+    double secs = timer.nsecsElapsed() / 1e9;
+
+    // Measured at the end of each generation, so take the figures for where the run stopped too
+    tank.measureMemory();
+    const MemoryUsage &memory = tank.memoryFigures();
+
+    m_out << used.width << "\t" << used.height << "\t" << used.startWorms << "\t" << used.startFood << "\t"
+          << used.tileSize << "\t" << int(ticks / secs) << "\t" << tank.generation() - firstGeneration << "\t"
+          << (memory.totalBytes() + 1023) / 1024 << "\t" << (memory.peakTotalBytes() + 1023) / 1024 << "\n";
+    m_out.flush();
+}
@@ -0,0 +1,33 @@
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include "tanksettings.h"
+#include <QString>
+#include <QTextStream>
+
+/**
+ * @brief Measures how fast tanks run as they get bigger
+ *
+ * Runs headless tanks of one worm type, growing the tank size, the
+ * number of worms and the amount of food in turn, then splitting a big
+ * tank into smaller and smaller tiles, and prints the ticks per second
+ * and memory used for each. Started with the --benchmark option.
+ */
+class Benchmark
+{
+public:
+    explicit Benchmark(QString wormType);
+
+    int run();
+
+private:
+    void runTank(const TankSettings &settings);
+
+    static const qint64 MinMsecs = 2000;
+    static const uint MinTicks = 10;
+
+    QString m_wormType;
+    QTextStream m_out;
+};
+
+#endif // BENCHMARK_H
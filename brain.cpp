@@ -3,6 +3,45 @@
 // Map to functions to create brains
 BrainFactory *BrainFactory::s_instance = nullptr;
 
+const quint64 Brain::HashStart;
+size_t Brain::s_objectBytes = 0;
+
+/**
+ * @brief Get a hash of everything that decides how the brain behaves
+ *
+ * Brains with the same hash can be taken to be identical. The default
+ * covers the type name and the genome, so brains with any other
+ * structure have to add it themselves.
+ *
+ * @return 64 bit hash that is the same from run to run
+ */
+quint64 Brain::contentHash() const
+{
+    const std::string &type = name();
+    quint64 hash = hashBytes(type.data(), type.size());
+    uint count;
+    const int *genes = genome(count);
+    return hashBytes(genes, count * sizeof(int), hash);
+}
+
+/**
+ * @brief Add bytes to a hash using FNV-1a
+ * @param data first byte to add
+ * @param size number of bytes
+ * @param hash hash so far
+ * @return updated hash
+ */
+quint64 Brain::hashBytes(const void *data, size_t size, quint64 hash)
+{
+    const unsigned char *bytes = static_cast<const unsigned char *>(data);
+    for (size_t j = 0; j < size; j++)
+    {
+        hash ^= bytes[j];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
 
 /**
  * @brief Register a new brain type
@@ -5,8 +5,10 @@
 #include <QDataStream>
 #include <map>
 #include <string>
+#include "memorypool.h"
 class Worm;
 class Brain;
+class MemoryUsage;
 
 /**
  * @brief The interface to the worms brain
@@ -17,6 +19,15 @@ public:
     Brain(Worm *worm) : m_worm(worm) {}
     virtual ~Brain() {}
 
+    // Brains are made and thrown away with their worms so come from the pool
+    static void *operator new(size_t size) {s_objectBytes += size; return MemoryPool::allocate(size);}
+    static void operator delete(void *ptr, size_t size) {s_objectBytes -= size; MemoryPool::release(ptr, size);}
+
+    /**
+     * @brief Number of bytes in all the brain objects that exist
+     */
+    static size_t objectBytes() {return s_objectBytes;}
+
 	/**
 	 * Return the brain name
 	 */
@@ -45,6 +56,15 @@ public:
 	 * @brief Make copy of the brain
 	*/
     virtual Brain *clone(Worm *worm) = 0;
+    /**
+     * @brief Make this brain a copy of another, keeping its storage
+     *
+     * Used instead of clone when a reused worm already has a brain.
+     *
+     * @param other brain to copy
+     * @return false if the brain can't be copied into this one
+     */
+    virtual bool copyFrom(const Brain &/*other*/) {return false;}
 	/**
 	 * @brief Randomise the brain
 	 * @param chance percentage chance that each element of the brain will change
@@ -65,6 +85,36 @@ public:
      */
     virtual void mix(Brain *other) = 0;
 
+    /**
+     * @brief Get the genes of the brain that evolve
+     *
+     * Brains that hold their weights in one array return it here so
+     * it can be worked on as a whole.
+     *
+     * @param count set to the number of genes
+     * @return first gene or nullptr if the brain has no genome
+     */
+    virtual const int *genome(uint &count) const {count = 0; return nullptr;}
+
+    virtual quint64 contentHash() const;
+
+    /**
+     * @brief Check if planning a move can change the brain
+     *
+     * A worm whose brain changes as it goes never repeats itself exactly,
+     * so the tank can't skip ticks while it is going round a loop.
+     */
+    virtual bool changesWhenMoving() const {return false;}
+
+    /**
+     * @brief Add the memory the brain uses outside its object
+     *
+     * The objects themselves are counted by objectBytes().
+     *
+     * @param usage where to add the bytes
+     */
+    virtual void memoryUsage(MemoryUsage &/*usage*/) const {}
+
 	/**
 	 * @brief save brain to byte stream
 	 * @param out QDataStream to save to
@@ -80,9 +130,14 @@ public:
 	inline int turnLeft(int dir) const { return (dir) ? dir - 1 : 3; }
 	inline int turnRight(int dir) const { return (dir < 3) ? dir + 1 : 0; }
 
+    static const quint64 HashStart = 14695981039346656037ULL;
+    static quint64 hashBytes(const void *data, size_t size, quint64 hash = HashStart);
+
 protected:
     Worm *m_worm;
 
+private:
+    static size_t s_objectBytes;
 };
 
 /**
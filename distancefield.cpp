@@ -0,0 +1,275 @@
+#include "distancefield.h"
+#include <deque>
+#include <queue>
+#include <functional>
+
+const int DistanceField::Unreachable;
+
+DistanceField::DistanceField() :
+    m_width(0),
+    m_height(0),
+    m_active(false)
+{
+}
+
+/**
+ * @brief Set the size of the field
+ *
+ * The field is freed until allocate() is called again
+ *
+ * @param width width of the tank
+ * @param height height of the tank
+ */
+void DistanceField::setSize(int width, int height)
+{
+    m_width = width;
+    m_height = height;
+    clear();
+}
+
+/**
+ * @brief Free the cells and stop maintaining the distances
+ */
+void DistanceField::clear()
+{
+    std::vector<unsigned char>().swap(m_state);
+    std::vector<int>().swap(m_distance);
+    m_active = false;
+}
+
+/**
+ * @brief Allocate the cells, all free, ready to set the states for a rebuild
+ */
+void DistanceField::allocate()
+{
+    m_state.assign(m_width * m_height, Free);
+    m_distance.assign(m_width * m_height, Unreachable);
+    m_active = false;
+}
+
+/**
+ * @brief Calculate the distances for the whole tank
+ *
+ * Once called the distances are kept up to date as the cells change.
+ */
+void DistanceField::rebuild()
+{
+    std::deque<int> queue;
+    for (uint idx = 0; idx < m_state.size(); idx++)
+    {
+        if (m_state[idx] == Source)
+        {
+            m_distance[idx] = 0;
+            queue.push_back(idx);
+        } else
+        {
+            m_distance[idx] = Unreachable;
+        }
+    }
+
+    int found[4];
+    while (!queue.empty())
+    {
+        int idx = queue.front();
+        queue.pop_front();
+        int numFound = neighbours(idx, found);
+        for (int j = 0; j < numFound; j++)
+        {
+            if (m_distance[found[j]] == Unreachable)
+            {
+                m_distance[found[j]] = m_distance[idx] + 1;
+                queue.push_back(found[j]);
+            }
+        }
+    }
+
+    m_active = true;
+}
+
+/**
+ * @brief Change the state of a cell
+ *
+ * Does nothing until the field is allocated. If the field is active the
+ * distances around the cell are repaired
+ *
+ * @param pt cell to change
+ * @param state new state of the cell
+ */
+void DistanceField::setState(QPoint pt, CellState state)
+{
+    if (m_state.empty()) return;
+    int idx = index(pt);
+    CellState oldState = CellState(m_state[idx]);
+    if (oldState == state) return;
+    m_state[idx] = state;
+    if (!m_active) return;
+
+    if (state == Source)
+    {
+        m_distance[idx] = 0;
+        lower(idx);
+    } else if (state == Free && oldState == Blocked)
+    {
+        m_distance[idx] = supportedDistance(idx);
+        if (m_distance[idx] != Unreachable) lower(idx);
+    } else
+    {
+        raise(idx);
+    }
+}
+
+/**
+ * @brief Get the distance from a cell to the nearest source
+ * @param pt cell to get the distance for
+ * @return number of moves or Unreachable
+ */
+int DistanceField::distance(QPoint pt) const
+{
+    if (pt.x() < 0 || pt.x() >= m_width || pt.y() < 0 || pt.y() >= m_height) return Unreachable;
+    return m_distance[index(pt)];
+}
+
+/**
+ * @brief Get the cells next to a cell that are not blocked
+ * @param idx cell index
+ * @param found array of 4 to return the neighbour indexes in
+ * @return number of neighbours found
+ */
+int DistanceField::neighbours(int idx, int *found) const
+{
+    int numFound = 0;
+    int x = idx % m_width;
+    if (x > 0 && m_state[idx - 1] != Blocked) found[numFound++] = idx - 1;
+    if (x < m_width - 1 && m_state[idx + 1] != Blocked) found[numFound++] = idx + 1;
+    if (idx >= m_width && m_state[idx - m_width] != Blocked) found[numFound++] = idx - m_width;
+    if (idx + m_width < int(m_state.size()) && m_state[idx + m_width] != Blocked) found[numFound++] = idx + m_width;
+    return numFound;
+}
+
+/**
+ * @brief Get the distance to a cell from its neighbours current distances
+ * @param idx cell index
+ * @return distance or Unreachable
+ */
+int DistanceField::supportedDistance(int idx) const
+{
+    if (m_state[idx] == Source) return 0;
+    if (m_state[idx] == Blocked) return Unreachable;
+
+    int found[4];
+    int numFound = neighbours(idx, found);
+    int best = Unreachable;
+    for (int j = 0; j < numFound; j++)
+    {
+        if (m_distance[found[j]] < best) best = m_distance[found[j]];
+    }
+    return (best == Unreachable) ? Unreachable : best + 1;
+}
+
+/**
+ * @brief Spread a reduced distance out from a cell
+ * @param idx cell whose distance has been lowered
+ */
+void DistanceField::lower(int idx)
+{
+    std::deque<int> queue;
+    queue.push_back(idx);
+    int found[4];
+    while (!queue.empty())
+    {
+        int from = queue.front();
+        queue.pop_front();
+        int numFound = neighbours(from, found);
+        for (int j = 0; j < numFound; j++)
+        {
+            if (m_distance[from] + 1 < m_distance[found[j]])
+            {
+                m_distance[found[j]] = m_distance[from] + 1;
+                queue.push_back(found[j]);
+            }
+        }
+    }
+}
+
+/**
+ * @brief Repair the distances after a cell has lost its source or been blocked
+ *
+ * First every cell whose distance only came through the changed cell is
+ * invalidated, then the distances of those cells are recalculated from
+ * the cells around them that are still valid.
+ *
+ * @param idx cell that has changed
+ */
+void DistanceField::raise(int idx)
+{
+    std::vector<int> invalid;
+    std::vector<int> stack;
+    int found[4];
+
+    invalid.push_back(idx);
+    stack.push_back(idx);
+    int oldDistance = m_distance[idx];
+    m_distance[idx] = Unreachable;
+    if (oldDistance != Unreachable)
+    {
+        // Walk down the distances to find cells that have lost their support
+        std::vector<int> stackDistance;
+        stackDistance.push_back(oldDistance);
+        while (!stack.empty())
+        {
+            int from = stack.back();
+            int fromDistance = stackDistance.back();
+            stack.pop_back();
+            stackDistance.pop_back();
+            int numFound = neighbours(from, found);
+            for (int j = 0; j < numFound; j++)
+            {
+                int cell = found[j];
+                if (m_distance[cell] != fromDistance + 1 || m_state[cell] == Source) continue;
+
+                int support[4];
+                int numSupport = neighbours(cell, support);
+                bool supported = false;
+                for (int k = 0; k < numSupport && !supported; k++)
+                {
+                    supported = (m_distance[support[k]] == fromDistance);
+                }
+                if (!supported)
+                {
+                    m_distance[cell] = Unreachable;
+                    invalid.push_back(cell);
+                    stack.push_back(cell);
+                    stackDistance.push_back(fromDistance + 1);
+                }
+            }
+        }
+    }
+
+    // Recalculate the invalidated cells from their valid neighbours
+    typedef std::pair<int, int> DistanceCell;
+    std::priority_queue<DistanceCell, std::vector<DistanceCell>, std::greater<DistanceCell> > queue;
+    for (auto cell : invalid)
+    {
+        int distance = supportedDistance(cell);
+        if (distance != Unreachable)
+        {
+            m_distance[cell] = distance;
+            queue.push(std::make_pair(distance, cell));
+        }
+    }
+    while (!queue.empty())
+    {
+        DistanceCell item = queue.top();
+        queue.pop();
+        if (item.first > m_distance[item.second]) continue;
+        int numFound = neighbours(item.second, found);
+        for (int j = 0; j < numFound; j++)
+        {
+            if (item.first + 1 < m_distance[found[j]])
+            {
+                m_distance[found[j]] = item.first + 1;
+                queue.push(std::make_pair(item.first + 1, found[j]));
+            }
+        }
+    }
+}
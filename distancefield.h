@@ -0,0 +1,57 @@
+#ifndef DISTANCEFIELD_H
+#define DISTANCEFIELD_H
+
+#include <QPoint>
+#include <vector>
+#include <climits>
+#include <atomic>
+
+/**
+ * @brief Path distance from every cell in the tank to the nearest source
+ *
+ * The distance is the number of moves needed to get to a source going
+ * round blocked cells. The field is only allocated and calculated once
+ * something asks for it, after that it is repaired locally as cells
+ * change rather than being rebuilt. Until allocate() is called setting
+ * the state of a cell does nothing, so the owner must set every cell
+ * that isn't free before the first rebuild().
+ */
+class DistanceField
+{
+public:
+    DistanceField();
+
+    enum CellState {Free, Source, Blocked};
+    static const int Unreachable = INT_MAX;
+
+    void setSize(int width, int height);
+    void clear();
+
+    bool active() const {return m_active;}
+    void allocate();
+    void rebuild();
+
+    void setState(QPoint pt, CellState state);
+    int distance(QPoint pt) const;
+
+    /**
+     * @brief Get the number of bytes allocated for the states and distances
+     */
+    size_t memoryBytes() const {return m_state.capacity() + m_distance.capacity() * sizeof(int);}
+
+private:
+    inline int index(QPoint pt) const {return pt.y() * m_width + pt.x();}
+    int neighbours(int idx, int *found) const;
+    int supportedDistance(int idx) const;
+    void lower(int idx);
+    void raise(int idx);
+
+private:
+    int m_width;
+    int m_height;
+    std::atomic<bool> m_active; // Set once the distances are complete, read by planning threads
+    std::vector<unsigned char> m_state;
+    std::vector<int> m_distance;
+};
+
+#endif // DISTANCEFIELD_H
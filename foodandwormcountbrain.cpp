@@ -9,6 +9,17 @@ BrainCreator<FoodAndWormCountBrain> g_foodAndWormCountBrainCreator(
         "Detect the amount of food and worms at ranges 1, 10, 100, infinity and if it's next to a wall"
         );
 
+/**
+ * @brief Construct a new brain with random weights
+ * @param worm worm to attach the brain to
+ */
+FoodAndWormCountBrain::FoodAndWormCountBrain(Worm *worm) : IOBrain(worm, 36)
+{
+    addSensorGroup(16, UnboundedInput);
+    addSensorGroup(16, UnboundedInput);
+    addSensorGroup(4, 1);
+}
+
 /**
  * @brief Return the name of this brain type
  * @return name of brain type
@@ -29,17 +40,24 @@ Brain *FoodAndWormCountBrain::clone(Worm *worm)
 }
 
 /**
- * @brief Fill the inputs with the food seen sensor data
+ * @brief Fill the inputs for one of the sensors
+ * @param group sensor group to fill
  * @param pt worm head position
  * @param dir directin worm is facing
  */
-void FoodAndWormCountBrain::fillInputs(QPoint pt, int dir)
+void FoodAndWormCountBrain::fillSensorGroup(uint group, QPoint pt, int dir)
 {
 	int ranges[4] = { 1,10,100, 99999 };
-    m_worm->tank()->foodCount(pt, dir, ranges, 4, m_inputs);
-    m_worm->tank()->wormCount(pt, dir, ranges, 4, m_inputs + 16);
-    m_worm->tank()->wallNextTo(pt, dir, m_inputs + 32);
+    switch (group)
+    {
+    case 0:
+        m_worm->tank()->foodCount(pt, dir, ranges, 4, m_inputs);
+        break;
+    case 1:
+        m_worm->tank()->wormCount(pt, dir, ranges, 4, m_inputs + 16);
+        break;
+    case 2:
+        m_worm->tank()->wallNextTo(pt, dir, m_inputs + 32);
+        break;
+    }
 }
-
-
-
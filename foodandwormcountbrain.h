@@ -6,7 +6,7 @@
 class FoodAndWormCountBrain : public IOBrain
 {
 public:
-    FoodAndWormCountBrain(Worm *worm) : IOBrain(worm, 36) {}
+    FoodAndWormCountBrain(Worm *worm);
     FoodAndWormCountBrain(const FoodAndWormCountBrain &other, Worm *worm) : IOBrain(other, worm) {}
     virtual ~FoodAndWormCountBrain(){}
 
@@ -14,7 +14,7 @@ public:
     virtual Brain *clone(Worm *worm);
 
 protected:
-    virtual void fillInputs(QPoint pt, int dir);
+    virtual void fillSensorGroup(uint group, QPoint pt, int dir);
 };
 
 
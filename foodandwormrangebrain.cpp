@@ -9,6 +9,17 @@ BrainCreator<FoodAndWormRangeBrain> g_foodAndWormRangeBrainCreator(
         "Detect food and worms at ranges 1, 10, 100, infinity and if it's next to a wall"
         );
 
+/**
+ * @brief Construct a new brain with random weights
+ * @param worm worm to attach the brain to
+ */
+FoodAndWormRangeBrain::FoodAndWormRangeBrain(Worm *worm) : IOBrain(worm, 36)
+{
+    addSensorGroup(16, 1);
+    addSensorGroup(16, 1);
+    addSensorGroup(4, 1);
+}
+
 /**
  * @brief Return the name of this brain type
  * @return name of brain type
@@ -29,17 +40,24 @@ Brain *FoodAndWormRangeBrain::clone(Worm *worm)
 }
 
 /**
- * @brief Fill the inputs with the food seen sensor data
+ * @brief Fill the inputs for one of the sensors
+ * @param group sensor group to fill
  * @param pt worm head position
  * @param dir directin worm is facing
  */
-void FoodAndWormRangeBrain::fillInputs(QPoint pt, int dir)
+void FoodAndWormRangeBrain::fillSensorGroup(uint group, QPoint pt, int dir)
 {
 	int ranges[4] = { 1,10,100, 99999 };
-	m_worm->tank()->foodSeen(pt, dir, ranges, 4, m_inputs);
-	m_worm->tank()->wormSeen(pt, dir, ranges, 4, m_inputs + 16);
-    m_worm->tank()->wallNextTo(pt, dir, m_inputs + 32);
+    switch (group)
+    {
+    case 0:
+        m_worm->tank()->foodSeen(pt, dir, ranges, 4, m_inputs);
+        break;
+    case 1:
+        m_worm->tank()->wormSeen(pt, dir, ranges, 4, m_inputs + 16);
+        break;
+    case 2:
+        m_worm->tank()->wallNextTo(pt, dir, m_inputs + 32);
+        break;
+    }
 }
-
-
-
@@ -6,7 +6,7 @@
 class FoodAndWormRangeBrain : public IOBrain
 {
 public:
-    FoodAndWormRangeBrain(Worm *worm) : IOBrain(worm, 36) {}
+    FoodAndWormRangeBrain(Worm *worm);
     FoodAndWormRangeBrain(const FoodAndWormRangeBrain &other, Worm *worm) : IOBrain(other, worm) {}
     virtual ~FoodAndWormRangeBrain(){}
 
@@ -14,7 +14,7 @@ public:
     virtual Brain *clone(Worm *worm);
 
 protected:
-    virtual void fillInputs(QPoint pt, int dir);
+    virtual void fillSensorGroup(uint group, QPoint pt, int dir);
 };
 
 
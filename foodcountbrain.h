@@ -6,7 +6,7 @@
 class FoodCountBrain : public IOBrain
 {
 public:
-    FoodCountBrain(Worm *worm) : IOBrain(worm, 24) {}
+    FoodCountBrain(Worm *worm);
     FoodCountBrain(const FoodCountBrain &other, Worm *worm) : IOBrain(other, worm) {}
     virtual ~FoodCountBrain(){}
 
@@ -14,7 +14,7 @@ public:
     virtual Brain *clone(Worm *worm);
 
 protected:
-    virtual void fillInputs(QPoint pt, int dir);
+    virtual void fillSensorGroup(uint group, QPoint pt, int dir);
 };
 
 
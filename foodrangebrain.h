@@ -6,7 +6,7 @@
 class FoodRangeBrain : public IOBrain
 {
 public:
-    FoodRangeBrain(Worm *worm) : IOBrain(worm, 24) {}
+    FoodRangeBrain(Worm *worm);
     FoodRangeBrain(const FoodRangeBrain &other, Worm *worm) : IOBrain(other, worm) {}
     virtual ~FoodRangeBrain(){}
 
@@ -14,7 +14,7 @@ public:
     virtual Brain *clone(Worm *worm);
 
 protected:
-    virtual void fillInputs(QPoint pt, int dir);
+    virtual void fillSensorGroup(uint group, QPoint pt, int dir);
 };
 
 
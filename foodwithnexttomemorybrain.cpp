@@ -3,7 +3,9 @@
 #include "wormtank.h"
 #include "direction.h"
 #include "random.h"
+#include "memoryusage.h"
 #include <sstream>
+#include <algorithm>
 
 // Register the simple brain creator
 BrainCreator<FoodWithNextToMemoryBrain> g_foodWithNextToMemoryBrainCreator(
@@ -17,7 +19,9 @@ BrainCreator<FoodWithNextToMemoryBrain> g_foodWithNextToMemoryBrainCreator(
  * @brief Construct a new brain with no memories
  * @param worm worm the brain is attached too
  */
-FoodWithNextToMemoryBrain::FoodWithNextToMemoryBrain(Worm *worm) : Brain(worm)
+FoodWithNextToMemoryBrain::FoodWithNextToMemoryBrain(Worm *worm) :
+    Brain(worm),
+    m_numMemories(0)
 {
     for (uint j = 0; j < MaxNewMemories; j++) m_newMemories[j] = 0;
 }
@@ -27,12 +31,12 @@ FoodWithNextToMemoryBrain::FoodWithNextToMemoryBrain(Worm *worm) : Brain(worm)
  * @param other brain to copy
  * @param worm worm to attach the new version to
  */
-FoodWithNextToMemoryBrain::FoodWithNextToMemoryBrain(const FoodWithNextToMemoryBrain &other, Worm *worm) : Brain(worm)
+FoodWithNextToMemoryBrain::FoodWithNextToMemoryBrain(const FoodWithNextToMemoryBrain &other, Worm *worm) :
+    Brain(worm),
+    m_numMemories(other.m_numMemories)
 {
-    for (auto memory : other.m_memories)
-    {
-        m_memories[memory.first] = memory.second;
-    }
+    std::copy(other.m_memoryBits, other.m_memoryBits + m_numMemories, m_memoryBits);
+    std::copy(other.m_memoryTurns, other.m_memoryTurns + m_numMemories, m_memoryTurns);
     for (uint j = 0; j < MaxNewMemories; j++)
     {
         m_newMemories[j] = other.m_newMemories[j];
@@ -58,6 +62,22 @@ Brain *FoodWithNextToMemoryBrain::FoodWithNextToMemoryBrain::clone(Worm *worm)
     return new FoodWithNextToMemoryBrain(*this, worm);
 }
 
+/**
+ * @brief Copy the memories of another brain into this one
+ * @param other brain to copy
+ * @return false if the other brain is a different type
+ */
+bool FoodWithNextToMemoryBrain::copyFrom(const Brain &other)
+{
+    if (other.name() != name()) return false;
+    const FoodWithNextToMemoryBrain &otherBrain = static_cast<const FoodWithNextToMemoryBrain &>(other);
+    m_numMemories = otherBrain.m_numMemories;
+    std::copy(otherBrain.m_memoryBits, otherBrain.m_memoryBits + m_numMemories, m_memoryBits);
+    std::copy(otherBrain.m_memoryTurns, otherBrain.m_memoryTurns + m_numMemories, m_memoryTurns);
+    std::copy(otherBrain.m_newMemories, otherBrain.m_newMemories + MaxNewMemories, m_newMemories);
+    return true;
+}
+
 
 /**
  * @brief Return the full name of the brain
@@ -69,7 +89,7 @@ Brain *FoodWithNextToMemoryBrain::FoodWithNextToMemoryBrain::clone(Worm *worm)
 std::string FoodWithNextToMemoryBrain::fullName() const
 {
     std::ostringstream os;
-    os << name() << "_M" << m_memories.size();
+    os << name() << "_M" << m_numMemories;
     return os.str();
 }
 
@@ -88,13 +108,13 @@ void FoodWithNextToMemoryBrain::planMove(QPoint &pt, int &dir)
     uint bit = 1;
     for (uint j = 0; j < NumInputs; j++)
     {
-        if (m_inputs[j].value()) bits |= bit;
+        if (m_inputs[j]) bits |= bit;
         bit <<=1;
     }
-    auto found = m_memories.find(bits);
-    if (found != m_memories.end())
+    int found = findMemory(bits);
+    if (found >= 0)
     {
-        dir = (dir + found->second + 4) % 4;
+        dir = (dir + m_memoryTurns[found] + 4) % 4;
     } else
     {
         // Randomly replace new memory
@@ -110,18 +130,18 @@ void FoodWithNextToMemoryBrain::planMove(QPoint &pt, int &dir)
  */
 void FoodWithNextToMemoryBrain::randomise(int chance, int weight)
 {
-    auto memory = m_memories.begin();
-    while (memory != m_memories.end())
+    uint memory = 0;
+    while (memory < m_numMemories)
     {
         if (randPercent() <= chance)
         {
             // Change direction
-            memory->second = randBelow(3);
+            m_memoryTurns[memory] = randBelow(3);
             memory++;
         } else if (randPercent() <= weight)
         {
             // Discard the memory
-            memory = m_memories.erase(memory);
+            eraseMemory(memory);
         } else
         {
             // Leave memory alone
@@ -131,11 +151,11 @@ void FoodWithNextToMemoryBrain::randomise(int chance, int weight)
 
     // Copy memories from new memories if there is space
     uint j = 0;
-    while (m_memories.size() < MaxMemories && j < MaxNewMemories)
+    while (m_numMemories < MaxMemories && j < MaxNewMemories)
     {
         if (m_newMemories[j] != 0)
         {
-            m_memories[m_newMemories[j]] = randBelow(3);
+            setMemory(m_newMemories[j], randBelow(3));
             m_newMemories[j] = 0;
         }
         j++;
@@ -153,18 +173,18 @@ void FoodWithNextToMemoryBrain::average(Brain *other)
 {
     FoodWithNextToMemoryBrain *otherBrain = dynamic_cast<FoodWithNextToMemoryBrain *>(other);
     if (otherBrain == nullptr) return; // Can only mix with brains of the same type
-    auto memory = m_memories.begin();
+    uint memory = 0;
 
-    while (memory != m_memories.end())
+    while (memory < m_numMemories)
     {
-        auto found = otherBrain->m_memories.find(memory->first);
-        if (found != otherBrain->m_memories.end())
+        int found = otherBrain->findMemory(m_memoryBits[memory]);
+        if (found >= 0)
         {
-            if (std::rand() & 1) memory->second = found->second;
+            if (std::rand() & 1) m_memoryTurns[memory] = otherBrain->m_memoryTurns[found];
             memory++;
         } else if (std::rand() & 1)
         {
-            memory = m_memories.erase(memory);
+            eraseMemory(memory);
         } else
         {
             memory++;
@@ -186,37 +206,66 @@ void FoodWithNextToMemoryBrain::mix(Brain *other)
 {
     FoodWithNextToMemoryBrain *otherBrain = dynamic_cast<FoodWithNextToMemoryBrain *>(other);
     if (otherBrain == nullptr) return; // Can only mix with brains of the same type
-    auto memory = m_memories.begin();
-    auto otherMemory = otherBrain->m_memories.begin();
+    uint memory = 0;
+    uint otherMemory = 0;
     // Erase half memories
-    while (memory != m_memories.end())
+    while (memory < m_numMemories)
     {
         if (std::rand() & 1)
         {
-            memory = m_memories.erase(memory);
+            eraseMemory(memory);
         } else
         {
             memory++;
         }
     }
     // Add half of other brain memories
-    while (otherMemory != otherBrain->m_memories.end() && m_memories.size() < MaxMemories)
+    while (otherMemory < otherBrain->m_numMemories && m_numMemories < MaxMemories)
     {
-        if (std::rand() & 1) m_memories[otherMemory->first] = otherMemory->second;
+        if (std::rand() & 1) setMemory(otherBrain->m_memoryBits[otherMemory], otherBrain->m_memoryTurns[otherMemory]);
         otherMemory++;
     }
 }
 
+/**
+ * @brief Get a hash of the brain including its memories
+ *
+ * The memories are kept sorted so brains with the same memories hash the same
+ *
+ * @return 64 bit hash of the brain
+ */
+quint64 FoodWithNextToMemoryBrain::contentHash() const
+{
+    quint64 hash = Brain::contentHash();
+    hash = hashBytes(&m_numMemories, sizeof(m_numMemories), hash);
+    hash = hashBytes(m_memoryBits, m_numMemories * sizeof(uint), hash);
+    return hashBytes(m_memoryTurns, m_numMemories * sizeof(int), hash);
+}
+
+/**
+ * @brief Show the memory tables as brain memories
+ *
+ * The tables are inside the brain object, so they are moved out of the
+ * bytes counted for the brain objects.
+ *
+ * @param usage where to add the bytes
+ */
+void FoodWithNextToMemoryBrain::memoryUsage(MemoryUsage &usage) const
+{
+    usage.transfer(MemoryUsage::Brains, MemoryUsage::Memories,
+                   sizeof(m_memoryBits) + sizeof(m_memoryTurns) + sizeof(m_newMemories));
+}
+
 /**
  * @brief save brain to byte stream
  * @param out QDataStream to save to
  */
 void FoodWithNextToMemoryBrain::write(QDataStream &out)
 {
-    out << (int)m_memories.size();
-    for (auto memory : m_memories)
+    out << (int)m_numMemories;
+    for (uint j = 0; j < m_numMemories; j++)
     {
-        out << memory.first << memory.second;
+        out << m_memoryBits[j] << m_memoryTurns[j];
     }
     out << MaxNewMemories;
     for (uint j = 0; j < MaxNewMemories; j++)
@@ -235,10 +284,11 @@ void FoodWithNextToMemoryBrain::read(QDataStream &in)
     in >> numMemories;
     uint bits;
     int dir;
+    m_numMemories = 0;
     for (uint j = 0; j < numMemories; j++)
     {
         in >> bits >> dir;
-        m_memories[bits] = dir;
+        setMemory(bits, dir);
     }
     in >> numMemories;
     uint newIdx = 0;
@@ -248,3 +298,51 @@ void FoodWithNextToMemoryBrain::read(QDataStream &in)
         if (newIdx < MaxNewMemories) m_newMemories[newIdx++] = bits;
     }
 }
+
+/**
+ * @brief Find the memory for a set of inputs
+ * @param bits inputs packed into bits
+ * @return index of the memory or -1 if there isn't one
+ */
+int FoodWithNextToMemoryBrain::findMemory(uint bits) const
+{
+    const uint *found = std::lower_bound(m_memoryBits, m_memoryBits + m_numMemories, bits);
+    if (found == m_memoryBits + m_numMemories || *found != bits) return -1;
+    return found - m_memoryBits;
+}
+
+/**
+ * @brief Set the turn for a set of inputs, adding a memory if needed
+ *
+ * Nothing is added if the brain already has the maximum number of memories
+ *
+ * @param bits inputs packed into bits
+ * @param turn turn to remember
+ */
+void FoodWithNextToMemoryBrain::setMemory(uint bits, int turn)
+{
+    uint idx = std::lower_bound(m_memoryBits, m_memoryBits + m_numMemories, bits) - m_memoryBits;
+    if (idx < m_numMemories && m_memoryBits[idx] == bits)
+    {
+        m_memoryTurns[idx] = turn;
+        return;
+    }
+    if (m_numMemories == MaxMemories) return;
+
+    std::copy_backward(m_memoryBits + idx, m_memoryBits + m_numMemories, m_memoryBits + m_numMemories + 1);
+    std::copy_backward(m_memoryTurns + idx, m_memoryTurns + m_numMemories, m_memoryTurns + m_numMemories + 1);
+    m_memoryBits[idx] = bits;
+    m_memoryTurns[idx] = turn;
+    m_numMemories++;
+}
+
+/**
+ * @brief Remove a memory
+ * @param idx index of the memory to remove
+ */
+void FoodWithNextToMemoryBrain::eraseMemory(uint idx)
+{
+    std::copy(m_memoryBits + idx + 1, m_memoryBits + m_numMemories, m_memoryBits + idx);
+    std::copy(m_memoryTurns + idx + 1, m_memoryTurns + m_numMemories, m_memoryTurns + idx);
+    m_numMemories--;
+}
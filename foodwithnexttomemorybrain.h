@@ -2,8 +2,6 @@
 #define FOODWITHNEXTTOMEMORYBRAIN_H
 
 #include "brain.h"
-#include "braincell.h"
-#include <map>
 
 class FoodWithNextToMemoryBrain : public Brain
 {
@@ -15,19 +13,31 @@ public:
     virtual const std::string &name() const;
     virtual std::string fullName() const;
     virtual void planMove(QPoint &pt, int &dir);
+    virtual bool changesWhenMoving() const {return true;} // Unknown situations are remembered
     virtual Brain *clone(Worm *worm);
+    virtual bool copyFrom(const Brain &other);
     virtual void randomise(int chance, int weight);
     virtual void average(Brain *other);
     virtual void mix(Brain *other);
+    virtual quint64 contentHash() const;
     virtual void write(QDataStream &out);
     virtual void read(QDataStream &in);
+    virtual void memoryUsage(MemoryUsage &usage) const;
+
+private:
+   int findMemory(uint bits) const;
+   void setMemory(uint bits, int turn);
+   void eraseMemory(uint idx);
 
 private:
    static const uint NumInputs = 16;
    static const uint MaxMemories = 40;
    static const uint MaxNewMemories = 5;
-   InputBrainCell m_inputs[NumInputs];
-   std::map<uint,int> m_memories;
+   int m_inputs[NumInputs];
+   // Memories are kept sorted by their input bits so they can be found with a binary search
+   uint m_numMemories;
+   uint m_memoryBits[MaxMemories];
+   int m_memoryTurns[MaxMemories];
    uint m_newMemories[MaxNewMemories];
 };
 
@@ -1,6 +1,7 @@
 #include "genlist.h"
 #include "brain.h"
 #include "wormtank.h"
+#include "movecost.h"
 
 GenList::GenList(QObject *parent) : QAbstractListModel(parent)
 {
@@ -41,6 +42,27 @@ void GenList::updateGeneration(QString wormType, uint newGen)
     }
 }
 
+/**
+ * @brief Update the move costs for the worm types that ran in the last generation
+ * @param costs costs from the tank
+ */
+void GenList::updateCosts(const MoveCosts &costs)
+{
+    for (uint j = 0; j < m_items.size(); j++)
+    {
+        MoveCost cost = costs.lastTypeCost(m_items[j].wormType().toStdString());
+        if (cost.moves() == 0) continue;
+
+        m_items[j].setCosts(cost.meanNsecs(), cost.percentile(50), cost.percentile(99), cost.totalNsecs());
+        QModelIndex index = createIndex(j,0);
+        QVector<int> roles;
+        roles.push_back(MeanMoveTimeRole);
+        roles.push_back(P50MoveTimeRole);
+        roles.push_back(P99MoveTimeRole);
+        roles.push_back(GenerationTimeRole);
+        emit dataChanged(index, index, roles);
+    }
+}
 
 /**
  * @brief Return role names for QML
@@ -51,6 +73,10 @@ QHash<int, QByteArray> GenList::roleNames() const
     QHash<int, QByteArray> roles = QAbstractListModel::roleNames();
     roles.insert(WormTypeRole, QByteArray("wormType"));
     roles.insert(GenerationRole, QByteArray("generation"));
+    roles.insert(MeanMoveTimeRole, QByteArray("meanMoveTime"));
+    roles.insert(P50MoveTimeRole, QByteArray("p50MoveTime"));
+    roles.insert(P99MoveTimeRole, QByteArray("p99MoveTime"));
+    roles.insert(GenerationTimeRole, QByteArray("generationTime"));
 
     return roles;
 }
@@ -66,12 +92,17 @@ QVariant GenList::data(const QModelIndex & index, int role) const
     if (!index.isValid())
         return QVariant();
 
-    if (role >= WormTypeRole && role <= GenerationRole)
+    if (role >= WormTypeRole && role <= GenerationTimeRole)
     {
+        const GenListItem &item = m_items[index.row()];
         switch(Roles(role))
         {
-        case WormTypeRole: return m_items[index.row()].wormType(); break;
-        case GenerationRole: return m_items[index.row()].generation(); break;
+        case WormTypeRole: return item.wormType(); break;
+        case GenerationRole: return item.generation(); break;
+        case MeanMoveTimeRole: return item.meanMoveNsecs() / 1000.0; break;
+        case P50MoveTimeRole: return item.p50MoveNsecs() / 1000.0; break;
+        case P99MoveTimeRole: return item.p99MoveNsecs() / 1000.0; break;
+        case GenerationTimeRole: return item.generationNsecs() / 1000000.0; break;
         }
     }
     return QVariant();
@@ -94,6 +125,10 @@ QVariant GenList::headerData(int section, Qt::Orientation orientation, int role)
         {
         case WormTypeRole: return "Worm Type"; break;
         case GenerationRole: return "Generation"; break;
+        case MeanMoveTimeRole: return "Mean us"; break;
+        case P50MoveTimeRole: return "p50 us"; break;
+        case P99MoveTimeRole: return "p99 us"; break;
+        case GenerationTimeRole: return "Generation ms"; break;
         }
     } else
     {
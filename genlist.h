@@ -3,6 +3,7 @@
 
 #include <QAbstractListModel>
 class WormTank;
+class MoveCosts;
 
 /**
  * @brief One item for GenList
@@ -12,11 +13,15 @@ class GenListItem
 public:
     GenListItem(QString wormType, uint generation) :
         m_wormType(wormType),
-        m_generation(generation)
+        m_generation(generation),
+        m_meanMoveNsecs(0),
+        m_p50MoveNsecs(0),
+        m_p99MoveNsecs(0),
+        m_generationNsecs(0)
     {
     }
 
-    GenListItem() : m_generation(0)
+    GenListItem() : m_generation(0), m_meanMoveNsecs(0), m_p50MoveNsecs(0), m_p99MoveNsecs(0), m_generationNsecs(0)
     {
     }
 
@@ -24,13 +29,34 @@ public:
     uint generation() const {return m_generation;}
     void setGeneration(uint newGen) {m_generation = newGen;}
 
+    // Time to plan a move and total time for the last generation the type was run
+    quint64 meanMoveNsecs() const {return m_meanMoveNsecs;}
+    quint64 p50MoveNsecs() const {return m_p50MoveNsecs;}
+    quint64 p99MoveNsecs() const {return m_p99MoveNsecs;}
+    quint64 generationNsecs() const {return m_generationNsecs;}
+    void setCosts(quint64 mean, quint64 p50, quint64 p99, quint64 total)
+    {
+        m_meanMoveNsecs = mean;
+        m_p50MoveNsecs = p50;
+        m_p99MoveNsecs = p99;
+        m_generationNsecs = total;
+    }
+
 private:
     QString m_wormType;
     uint m_generation;
+    quint64 m_meanMoveNsecs;
+    quint64 m_p50MoveNsecs;
+    quint64 m_p99MoveNsecs;
+    quint64 m_generationNsecs;
 };
 
 /**
  * @brief List of worm types and their current generation
+ *
+ * Also shows how long each type takes to plan a move, in microseconds,
+ * and the total time spent planning in its last generation, in
+ * milliseconds, so the cost of a type can be set against its results.
  */
 class GenList : public QAbstractListModel
 {
@@ -40,11 +66,16 @@ public:
     void setup(WormTank *wormTank);
 
     void updateGeneration(QString wormType, uint newGen);
+    void updateCosts(const MoveCosts &costs);
 
     enum Roles
     {
        WormTypeRole = Qt::UserRole + 0,
-       GenerationRole
+       GenerationRole,
+       MeanMoveTimeRole,
+       P50MoveTimeRole,
+       P99MoveTimeRole,
+       GenerationTimeRole
     };
 
     // Abstract table model overrides
@@ -0,0 +1,115 @@
+#include "genome.h"
+#include "random.h"
+
+// State of the genome random number generator, 0 until it is seeded
+static uint64_t s_genomeRandomState = 0;
+
+/**
+ * @brief Scale a 32 bit random number to 0 to range - 1
+ */
+static inline uint scaleRandom(uint32_t random, uint range)
+{
+    return uint((uint64_t(random) * range) >> 32);
+}
+
+/**
+ * @brief Start the genome random number generator from a known state
+ *
+ * The generator only takes a seed from std::rand the first time it is
+ * used, so a run that calls srand to repeat itself has to call this too.
+ *
+ * @param seed any value, including 0
+ */
+void seedGenomeRandom(uint64_t seed)
+{
+    // splitmix64 so that small seeds still give a well mixed state
+    seed += 0x9E3779B97F4A7C15ULL;
+    seed = (seed ^ (seed >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    seed = (seed ^ (seed >> 27)) * 0x94D049BB133111EBULL;
+    seed ^= seed >> 31;
+    s_genomeRandomState = seed ? seed : 1;
+}
+
+/**
+ * @brief Get a 64 bit random number
+ *
+ * Uses xorshift64*, seeded from std::rand the first time it is called
+ * unless seedGenomeRandom has been called first.
+ *
+ * @return random number
+ */
+uint64_t genomeRandom()
+{
+    if (s_genomeRandomState == 0)
+    {
+        s_genomeRandomState = (uint64_t(std::rand()) << 32) ^ uint64_t(std::rand()) ^ 0x9E3779B97F4A7C15ULL;
+    }
+    s_genomeRandomState ^= s_genomeRandomState >> 12;
+    s_genomeRandomState ^= s_genomeRandomState << 25;
+    s_genomeRandomState ^= s_genomeRandomState >> 27;
+    return s_genomeRandomState * 0x2545F4914F6CDD1DULL;
+}
+
+/**
+ * @brief Choose random changes to make to genes
+ *
+ * The genes are not changed so a brain that shares its genes can tell
+ * if it needs its own copy before applying the changes. The list is
+ * reused by every call, as brains are only bred on one thread.
+ *
+ * @param count number of genes
+ * @param chance percentage chance each gene will change
+ * @param weight maximum change to a gene (+/- weight)
+ * @return the changes that are not 0, in gene order
+ */
+const PoolVector<GeneChange> &pickMutations(uint count, int chance, int weight)
+{
+    // Made on first use so it is freed before the pool
+    static PoolVector<GeneChange> changes;
+    changes.clear();
+    if (chance <= 0 || weight < 0) return changes;
+
+    uint range = 2 * weight + 1;
+    for (uint j = 0; j < count; j++)
+    {
+        uint64_t random = genomeRandom();
+        // Top half decides if the gene changes, bottom half by how much
+        if (int(scaleRandom(uint32_t(random >> 32), 100)) < chance)
+        {
+            int change = int(scaleRandom(uint32_t(random), range)) - weight;
+            if (change != 0) changes.push_back(GeneChange{j, change});
+        }
+    }
+    return changes;
+}
+
+/**
+ * @brief Replace genes with the average of them and another set
+ * @param genes first gene to change
+ * @param otherGenes first gene to average with
+ * @param count number of genes
+ */
+void averageGenes(int *genes, const int *otherGenes, uint count)
+{
+    for (uint j = 0; j < count; j++) genes[j] = (genes[j] + otherGenes[j]) / 2;
+}
+
+/**
+ * @brief Replace each gene with 50% chance by the gene from another set
+ * @param genes first gene to change
+ * @param otherGenes first gene to take from
+ * @param count number of genes
+ */
+void mixGenes(int *genes, const int *otherGenes, uint count)
+{
+    for (uint first = 0; first < count; first += 64)
+    {
+        uint64_t choose = genomeRandom();
+        uint last = (count - first < 64) ? count : first + 64;
+        for (uint j = first; j < last; j++)
+        {
+            if (choose & 1) genes[j] = otherGenes[j];
+            choose >>= 1;
+        }
+    }
+}
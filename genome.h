@@ -0,0 +1,32 @@
+#ifndef GENOME_H
+#define GENOME_H
+
+#include <QtGlobal>
+#include <cstdint>
+#include "memorypool.h"
+
+/**
+ * @brief Helpers to breed brains whose weights are held in one array
+ *
+ * A genome is the contiguous array of ints that evolves in a brain.
+ * Children are made by mutating, averaging and mixing genomes, which
+ * these functions do over the whole array in one go using a fast
+ * random number generator rather than std::rand for every gene.
+ */
+
+/**
+ * @brief Change to make to one gene
+ */
+struct GeneChange
+{
+    uint gene;
+    int change;
+};
+
+void seedGenomeRandom(uint64_t seed);
+uint64_t genomeRandom();
+const PoolVector<GeneChange> &pickMutations(uint count, int chance, int weight);
+void averageGenes(int *genes, const int *otherGenes, uint count);
+void mixGenes(int *genes, const int *otherGenes, uint count);
+
+#endif // GENOME_H
@@ -0,0 +1,310 @@
+#include "hiddenlayerbrain.h"
+#include "worm.h"
+#include "wormtank.h"
+#include "direction.h"
+#include "random.h"
+#include "genome.h"
+#include "memoryusage.h"
+#include <algorithm>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+const int HiddenLayerBrain::ActivationLimit;
+const int HiddenLayerBrain::MaxWeight;
+
+/**
+ * @brief Creates hidden layer brains with a set number of hidden cells
+ */
+class HiddenLayerBrainCreator : public BrainCreatorBase
+{
+public:
+    HiddenLayerBrainCreator(const char *name, const char *summary, uint numHidden) :
+        BrainCreatorBase(name, summary),
+        m_numHidden(numHidden)
+    {
+    }
+
+    virtual Brain *create(Worm *worm) {return new HiddenLayerBrain(worm, this, m_numHidden);}
+
+private:
+    uint m_numHidden;
+};
+
+// Register the hidden layer brain creators
+HiddenLayerBrainCreator g_hiddenLayerBrainCreator(
+        "HiddenLayer",
+        "Detects direction food is in, if it's next to food, a worm or wall"
+        " and the shortest way to food, through a layer of 8 hidden cells.",
+        8
+        );
+
+HiddenLayerBrainCreator g_hiddenLayerWideBrainCreator(
+        "HiddenLayerWide",
+        "Same sensors as HiddenLayer through a layer of 16 hidden cells.",
+        16
+        );
+
+/**
+ * @brief Sum of weights multiplied by values
+ * @param weights first weight
+ * @param values first value
+ * @param count number of weights, must be a multiple of 8
+ * @return sum
+ */
+static inline int dotProduct(const qint8 *weights, const qint16 *values, uint count)
+{
+#ifdef __SSE2__
+    __m128i sum = _mm_setzero_si128();
+    for (uint j = 0; j < count; j += 8)
+    {
+        __m128i packed = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(weights + j));
+        // Sign extend the 8 weights to 16 bits
+        __m128i wide = _mm_srai_epi16(_mm_unpacklo_epi8(packed, packed), 8);
+        __m128i value = _mm_loadu_si128(reinterpret_cast<const __m128i *>(values + j));
+        sum = _mm_add_epi32(sum, _mm_madd_epi16(wide, value));
+    }
+    sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0x4E));
+    sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0xB1));
+    return _mm_cvtsi128_si32(sum);
+#else
+    int sum = 0;
+    for (uint j = 0; j < count; j++) sum += weights[j] * values[j];
+    return sum;
+#endif
+}
+
+/**
+ * @brief Construct a new brain with random weights
+ * @param worm worm the brain is attached to
+ * @param creator creator of the brain type
+ * @param numHidden number of hidden cells
+ */
+HiddenLayerBrain::HiddenLayerBrain(Worm *worm, const BrainCreatorBase *creator, uint numHidden) :
+    Brain(worm),
+    m_creator(creator),
+    m_numHidden(numHidden),
+    m_hiddenStride((numHidden + 8) & ~7u),
+    m_kernelValid(false)
+{
+    m_genes.resize(numHidden * (NumInputs + 1) + 2 * (numHidden + 1));
+    for (auto &gene : m_genes) gene = randBetween(-5, 5);
+
+    std::fill(m_inputs, m_inputs + NumInputs, 0);
+    std::fill(m_inputValues, m_inputValues + InputStride, 0);
+    m_inputValues[NumInputs] = 1;
+    m_hiddenValues.assign(m_hiddenStride, 0);
+    m_hiddenValues[numHidden] = 1;
+}
+
+/**
+ * @brief Construct a copy of the brain and attach it to a different worm
+ * @param other brain to copy
+ * @param worm worm to attach the new version to
+ */
+HiddenLayerBrain::HiddenLayerBrain(const HiddenLayerBrain &other, Worm *worm) :
+    Brain(worm),
+    m_creator(other.m_creator),
+    m_numHidden(other.m_numHidden),
+    m_hiddenStride(other.m_hiddenStride),
+    m_genes(other.m_genes),
+    m_kernelValid(other.m_kernelValid),
+    m_hiddenWeights(other.m_hiddenWeights),
+    m_outputWeights(other.m_outputWeights),
+    m_hiddenValues(other.m_hiddenValues)
+{
+    std::fill(m_inputs, m_inputs + NumInputs, 0);
+    std::copy(other.m_inputValues, other.m_inputValues + InputStride, m_inputValues);
+}
+
+/**
+ * @brief Return the name of this brain type
+ * @return name of brain type
+ */
+const std::string &HiddenLayerBrain::name() const
+{
+    return m_creator->name();
+}
+
+/**
+ * @brief Clone a copy of this brain
+ * @param worm worm to attach clone to
+ * @return new Brain copy
+ */
+Brain *HiddenLayerBrain::clone(Worm *worm)
+{
+    return new HiddenLayerBrain(*this, worm);
+}
+
+/**
+ * @brief Make this brain a copy of another of the same type
+ *
+ * The genes are copied into the ones the brain has and the int8 weights
+ * are rebuilt in place on the next move.
+ *
+ * @param other brain to copy
+ * @return false if the other brain is a different type
+ */
+bool HiddenLayerBrain::copyFrom(const Brain &other)
+{
+    if (other.name() != name()) return false;
+    const HiddenLayerBrain &otherBrain = static_cast<const HiddenLayerBrain &>(other);
+    m_genes = otherBrain.m_genes;
+    m_kernelValid = false;
+    return true;
+}
+
+/**
+ * @brief plan then next move to make
+ * @param pt position after move (initialised to current head before call)
+ * @param dir direction taken (initialised to current direction before call)
+ */
+void HiddenLayerBrain::planMove(QPoint &pt, int &dir)
+{
+    if (!m_kernelValid) setupKernel();
+    fillInputs(pt, dir);
+
+    for (uint h = 0; h < m_numHidden; h++)
+    {
+        int sum = dotProduct(&m_hiddenWeights[h * InputStride], m_inputValues, InputStride);
+        m_hiddenValues[h] = qint16(qBound(-ActivationLimit, sum, ActivationLimit));
+    }
+    bool left = dotProduct(&m_outputWeights[0], m_hiddenValues.data(), m_hiddenStride) > 0;
+    bool right = dotProduct(&m_outputWeights[m_hiddenStride], m_hiddenValues.data(), m_hiddenStride) > 0;
+
+    if (left && !right) dir = turnLeft(dir);
+    if (right && !left) dir = turnRight(dir);
+    movePoint(pt, dir);
+}
+
+/**
+ * @brief Read the sensors into the input values
+ * @param pt The head position of the worm
+ * @param dir the direction the worm is facing
+ */
+void HiddenLayerBrain::fillInputs(QPoint pt, int dir)
+{
+    WormTank *tank = m_worm->tank();
+    tank->foodSeen(pt, dir, m_inputs);
+    tank->foodNextTo(pt, dir, m_inputs + 4);
+    tank->wormNextTo(pt, dir, m_inputs + 8);
+    tank->wallNextTo(pt, dir, m_inputs + 12);
+    tank->foodGradient(pt, dir, m_inputs + 16);
+    for (uint k = 0; k < NumInputs; k++) m_inputValues[k] = qint16(m_inputs[k]);
+}
+
+/**
+ * @brief Build the int8 weight rows from the genes
+ *
+ * The bias of each cell goes in the column that lines up with the
+ * constant 1 value, the padding columns are 0.
+ */
+void HiddenLayerBrain::setupKernel()
+{
+    m_hiddenWeights.assign(m_numHidden * InputStride, 0);
+    const int *gene = m_genes.data();
+    for (uint h = 0; h < m_numHidden; h++)
+    {
+        qint8 *row = &m_hiddenWeights[h * InputStride];
+        row[NumInputs] = qint8(*gene++);
+        for (uint k = 0; k < NumInputs; k++) row[k] = qint8(*gene++);
+    }
+
+    m_outputWeights.assign(2 * m_hiddenStride, 0);
+    for (uint j = 0; j < 2; j++)
+    {
+        qint8 *row = &m_outputWeights[j * m_hiddenStride];
+        row[m_numHidden] = qint8(*gene++);
+        for (uint h = 0; h < m_numHidden; h++) row[h] = qint8(*gene++);
+    }
+    m_kernelValid = true;
+}
+
+/**
+ * @brief Keep the genes in the range of the int8 weights and rebuild them
+ */
+void HiddenLayerBrain::genesChanged()
+{
+    for (auto &gene : m_genes) gene = qBound(-MaxWeight, gene, MaxWeight);
+    m_kernelValid = false;
+}
+
+/**
+ * @brief Randomise the weights
+ * @param chance percentage chance that each weight will change
+ * @param weight the amount of change (+/- weight)
+ */
+void HiddenLayerBrain::randomise(int chance, int weight)
+{
+    const PoolVector<GeneChange> &changes = pickMutations(m_genes.size(), chance, weight);
+    if (changes.empty()) return;
+
+    for (auto change : changes) m_genes[change.gene] += change.change;
+    genesChanged();
+}
+
+/**
+ * @brief Average the weights with another brain with the same number of hidden cells
+ * @param other brain to average with
+ */
+void HiddenLayerBrain::average(Brain *other)
+{
+    HiddenLayerBrain *otherBrain = dynamic_cast<HiddenLayerBrain *>(other);
+    if (otherBrain == nullptr || otherBrain->m_numHidden != m_numHidden) return;
+
+    averageGenes(m_genes.data(), otherBrain->m_genes.data(), m_genes.size());
+    genesChanged();
+}
+
+/**
+ * @brief Mix the weights with another brain with the same number of hidden cells
+ * @param other brain to mix with
+ */
+void HiddenLayerBrain::mix(Brain *other)
+{
+    HiddenLayerBrain *otherBrain = dynamic_cast<HiddenLayerBrain *>(other);
+    if (otherBrain == nullptr || otherBrain->m_numHidden != m_numHidden) return;
+
+    mixGenes(m_genes.data(), otherBrain->m_genes.data(), m_genes.size());
+    genesChanged();
+}
+
+/**
+ * @brief Add the genes, the int8 kernel made from them and the hidden cells
+ * @param usage where to add the bytes
+ */
+void HiddenLayerBrain::memoryUsage(MemoryUsage &usage) const
+{
+    usage.add(MemoryUsage::Weights, MemoryUsage::vectorBytes(m_genes)
+              + MemoryUsage::vectorBytes(m_hiddenWeights)
+              + MemoryUsage::vectorBytes(m_outputWeights));
+    usage.add(MemoryUsage::Brains, MemoryUsage::vectorBytes(m_hiddenValues));
+}
+
+/**
+ * @brief save brain to byte stream
+ * @param out QDataStream to save to
+ */
+void HiddenLayerBrain::write(QDataStream &out)
+{
+    out << (int)m_genes.size();
+    for (auto gene : m_genes) out << gene;
+}
+
+/**
+ * @brief load brain from byte stream
+ * @param in QDataStream to load from
+ */
+void HiddenLayerBrain::read(QDataStream &in)
+{
+    int numGenes;
+    in >> numGenes;
+    Q_ASSERT(uint(numGenes) == m_genes.size());
+    for (int j = 0; j < numGenes; j++)
+    {
+        int gene;
+        in >> gene;
+        if (uint(j) < m_genes.size()) m_genes[j] = gene;
+    }
+    genesChanged();
+}
@@ -0,0 +1,66 @@
+#ifndef HIDDENLAYERBRAIN_H
+#define HIDDENLAYERBRAIN_H
+
+#include "brain.h"
+#include <vector>
+
+/**
+ * @brief Brain with a layer of hidden cells between the inputs and outputs
+ *
+ * Each hidden cell sums its weighted inputs and saturates the result at
+ * +/- ActivationLimit. The two outputs then sum the weighted hidden
+ * cells, their signs choosing the turn in the same way as IOBrain.
+ *
+ * The genome is kept as ints so it can be bred like the other brains,
+ * but every gene is limited to the range of an 8 bit int. The moves are
+ * worked out from an int8 copy of the weights laid out for a vectorised
+ * dot product.
+ */
+class HiddenLayerBrain : public Brain
+{
+public:
+    HiddenLayerBrain(Worm *worm, const BrainCreatorBase *creator, uint numHidden);
+    HiddenLayerBrain(const HiddenLayerBrain &other, Worm *worm);
+    virtual ~HiddenLayerBrain() {}
+
+    virtual const std::string &name() const;
+    virtual void planMove(QPoint &pt, int &dir);
+    virtual Brain *clone(Worm *worm);
+    virtual bool copyFrom(const Brain &other);
+    virtual void randomise(int chance, int weight);
+    virtual void average(Brain *other);
+    virtual void mix(Brain *other);
+    virtual const int *genome(uint &count) const {count = m_genes.size(); return m_genes.data();}
+    virtual void write(QDataStream &out);
+    virtual void read(QDataStream &in);
+    virtual void memoryUsage(MemoryUsage &usage) const;
+
+private:
+    void genesChanged();
+    void setupKernel();
+    void fillInputs(QPoint pt, int dir);
+
+private:
+    static const uint NumInputs = 20;
+    static const uint InputStride = 24; // Inputs, a constant 1 for the bias and padding to a multiple of 8
+    static const int ActivationLimit = 32;
+    static const int MaxWeight = 127;
+
+    const BrainCreatorBase *m_creator;
+    uint m_numHidden;
+    uint m_hiddenStride; // Hidden cells, a constant 1 for the bias and padding to a multiple of 8
+    // For each hidden cell its bias then input weights, followed by the
+    // bias and hidden cell weights for each output
+    PoolVector<int> m_genes;
+
+    // Int8 weights built from the genes, one padded row per cell
+    bool m_kernelValid;
+    PoolVector<qint8> m_hiddenWeights;
+    PoolVector<qint8> m_outputWeights;
+
+    int m_inputs[NumInputs];
+    qint16 m_inputValues[InputStride];
+    PoolVector<qint16> m_hiddenValues;
+};
+
+#endif // HIDDENLAYERBRAIN_H
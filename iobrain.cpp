@@ -1,6 +1,20 @@
 #include "iobrain.h"
 #include "random.h"
 #include "direction.h"
+#include "genome.h"
+#include "memoryusage.h"
+#include <algorithm>
+#include <climits>
+#include <vector>
+
+const uint IOBrain::BinaryBlockSize;
+
+// Only evaluate the sensors needed to decide the move
+bool IOBrain::s_lazySensing = true;
+// Remember the decisions of brains with only binary inputs
+bool IOBrain::s_decisionTables = true;
+// Bytes in the decision tables of all the brains
+std::atomic<size_t> IOBrain::s_decisionTableBytes(0);
 
 /**
  * @brief Create the IOBrain base class
@@ -10,16 +24,22 @@
  */
 IOBrain::IOBrain(Worm *worm, uint numInputs) :
     Brain(worm),
-    m_numInputs(numInputs),
-    m_inputs(nullptr)
+    m_numInputs(0),
+    m_inputs(nullptr),
+    m_weights(std::allocate_shared<Weights>(PoolAllocator<Weights>(), numInputs * 2)),
+    m_inputCapacity(0),
+    m_blocksValid(false),
+    m_lazyValid(false),
+    m_decisionsValid(false),
+    m_useDecisions(false)
 {
-    m_inputs = new InputBrainCell[numInputs];
+    resizeInputs(numInputs);
     // Initialise the brain with random weights
     for (int j = 0; j < 2; j++)
     {
         for (uint k = 0; k < m_numInputs; k++)
         {
-            m_outputs[j].addLink(&m_inputs[k], randBetween(-5, 5));
+            setInputWeight(j, k, randBetween(-5, 5));
         }
     }
 }
@@ -31,33 +51,129 @@ IOBrain::IOBrain(Worm *worm, uint numInputs) :
  */
 IOBrain::IOBrain(const IOBrain &other, Worm *worm) :
     Brain(worm),
-    m_numInputs(other.m_numInputs),
-    m_inputs(nullptr)
+    m_numInputs(0),
+    m_inputs(nullptr),
+    m_weights(other.m_weights),
+    m_sensorGroups(other.m_sensorGroups),
+    m_inputCapacity(0),
+    m_blocksValid(false),
+    m_lazyValid(false),
+    m_decisionsValid(false),
+    m_useDecisions(false)
 {
-    m_inputs = new InputBrainCell[m_numInputs];
-    // Initialise the brain with random weights
-    for (int j = 0; j < 2; j++)
+    resizeInputs(other.m_numInputs);
+}
+
+IOBrain::~IOBrain()
+{
+    releaseDecisionTable();
+    MemoryPool::release(m_inputs, m_inputCapacity * sizeof(int));
+}
+
+/**
+ * @brief Make this brain a copy of another of the same type
+ *
+ * The weights are shared as they are by a clone. The inputs and the
+ * tables keep their storage and are rebuilt on the next move.
+ *
+ * @param other brain to copy
+ * @return false if the other brain is a different type
+ */
+bool IOBrain::copyFrom(const Brain &other)
+{
+    if (other.name() != name()) return false;
+    const IOBrain &otherBrain = static_cast<const IOBrain &>(other);
+
+    resizeInputs(otherBrain.m_numInputs);
+    if (m_weights != otherBrain.m_weights)
     {
-        for (uint k = 0; k < m_numInputs; k++)
-        {
-            m_outputs[j].addLink(&m_inputs[k], other.m_outputs[j].weight(k));
-        }
+        if (m_weights.use_count() == 1) m_spareWeights = std::move(m_weights);
+        m_weights = otherBrain.m_weights;
     }
+    m_sensorGroups = otherBrain.m_sensorGroups;
+    weightsChanged();
+    return true;
 }
 
-IOBrain::~IOBrain()
+/**
+ * @brief Get the weights to change them
+ *
+ * Makes a copy of the weights first if they are shared with another
+ * brain, into the spare weights if the brain has kept some.
+ *
+ * @return the weights
+ */
+IOBrain::Weights &IOBrain::ownWeights()
+{
+    if (m_weights.use_count() > 1)
+    {
+        if (m_spareWeights) *m_spareWeights = *m_weights;
+        else m_spareWeights = std::allocate_shared<Weights>(PoolAllocator<Weights>(), *m_weights);
+        m_weights = std::move(m_spareWeights);
+    }
+    return *m_weights;
+}
+
+/**
+ * @brief Change the number of inputs
+ *
+ * The buffer is only replaced if it is too small. The values of the
+ * inputs that were there are kept and any new ones are 0.
+ *
+ * @param numInputs number of inputs
+ */
+void IOBrain::resizeInputs(uint numInputs)
+{
+    if (numInputs > m_inputCapacity)
+    {
+        int *inputs = static_cast<int *>(MemoryPool::allocate(numInputs * sizeof(int)));
+        std::copy(m_inputs, m_inputs + m_numInputs, inputs);
+        MemoryPool::release(m_inputs, m_inputCapacity * sizeof(int));
+        m_inputs = inputs;
+        m_inputCapacity = numInputs;
+    }
+    if (numInputs > m_numInputs) std::fill(m_inputs + m_numInputs, m_inputs + numInputs, 0);
+    m_numInputs = numInputs;
+}
+
+/**
+ * @brief Add the inputs, the weights and the tables cached from them
+ * @param usage where to add the bytes
+ */
+void IOBrain::memoryUsage(MemoryUsage &usage) const
 {
-    delete [] m_inputs;
+    usage.addShared(MemoryUsage::Weights, m_weights.get(), sizeof(*m_weights) + MemoryUsage::vectorBytes(*m_weights));
+    if (m_spareWeights) usage.add(MemoryUsage::Weights, sizeof(*m_spareWeights) + MemoryUsage::vectorBytes(*m_spareWeights));
+    usage.add(MemoryUsage::Brains, m_inputCapacity * sizeof(int)
+              + MemoryUsage::vectorBytes(m_sensorGroups)
+              + MemoryUsage::vectorBytes(m_binaryBlocks)
+              + MemoryUsage::vectorBytes(m_blockSums)
+              + MemoryUsage::vectorBytes(m_groupBlocks)
+              + MemoryUsage::vectorBytes(m_lazyGroups)
+              + MemoryUsage::vectorBytes(m_decisions)
+              + MemoryUsage::vectorBytes(m_decisionOffsets));
 }
 
 void IOBrain::write(QDataStream &out)
 {
-    for (int j = 0; j < 2; j++) m_outputs[j].writeWeights(out);
+    for (int j = 0; j < 2; j++)
+    {
+        for (uint k = 0; k < m_numInputs; k++) out << inputWeight(j, k);
+    }
 }
 
 void IOBrain::read(QDataStream &in)
 {
-    for (int j = 0; j < 2; j++) m_outputs[j].readWeights(in);
+    for (int j = 0; j < 2; j++)
+    {
+        for (uint k = 0; k < m_numInputs; k++)
+        {
+            int weight;
+            in >> weight;
+            setInputWeight(j, k, weight);
+        }
+    }
+    weightsChanged();
 }
 
 
@@ -66,49 +182,462 @@ void IOBrain::read(QDataStream &in)
  *
  * Clears the inputs and calls the sub class fillInputs to set the
  * initial input, then gets the output values and set the move/direction
- * accordingly
+ * accordingly.
+ *
+ * If lazy sensing is on and the brain has more than one sensor group
+ * only the sensors required to decide the move are used. Brains with
+ * only binary inputs look up the decision in their decision table.
  *
  * @param pt point of worms head
  * @param dir direction worm is travelling in
  */
 void IOBrain::planMove(QPoint &pt, int &dir)
 {
-    fillInputs(pt, dir);
+    bool left, right;
+    if (s_decisionTables && !m_decisionsValid) setupDecisionTable();
+    if (s_decisionTables && m_useDecisions)
+    {
+        tableOutputs(pt, dir, left, right);
+    } else if (s_lazySensing && m_sensorGroups.size() > 1)
+    {
+        lazyOutputs(pt, dir, left, right);
+    } else
+    {
+        fillInputs(pt, dir);
+        long long leftValue, rightValue;
+        outputValues(leftValue, rightValue);
+        left = (leftValue > 0);
+        right = (rightValue > 0);
+    }
 
-    bool left = (m_outputs[0].value() > 0);
-    bool right = (m_outputs[1].value() > 0);
     if (left && !right)	dir = turnLeft(dir);
     if (right && !left) dir = turnRight(dir);
     movePoint(pt, dir);
 }
 
-void IOBrain::average(Brain *other)
+/**
+ * @brief Calculate the values of both outputs from the current inputs
+ * @param left set to the weighted sum of the inputs for the left output
+ * @param right set to the weighted sum of the inputs for the right output
+ */
+void IOBrain::outputValues(long long &left, long long &right)
 {
-    IOBrain *otherBrain = dynamic_cast<IOBrain *>(other);
-    if (otherBrain == nullptr) return; // Can only work with another SimpleBrain
+    long long sums[2] = {0, 0};
+    if (m_sensorGroups.empty())
+    {
+        const int *weights = m_weights->data();
+        for (uint k = 0; k < m_numInputs; k++)
+        {
+            sums[0] += (long long)weights[2 * k] * m_inputs[k];
+            sums[1] += (long long)weights[2 * k + 1] * m_inputs[k];
+        }
+    } else
+    {
+        if (!m_blocksValid) setupBinaryBlocks();
+        for (uint group = 0; group < m_sensorGroups.size(); group++) addGroupSums(group, sums);
+    }
+    left = sums[0];
+    right = sums[1];
+}
 
-    for (int j = 0; j < 2; j++)
+/**
+ * @brief Precalculate the output sums for the binary sensor groups
+ *
+ * The inputs of a group whose inputs are only ever 0 or 1 are split into
+ * blocks of up to BinaryBlockSize inputs. For every pattern of set inputs
+ * in a block the sum of their weights is stored, so the block adds to
+ * each output with one table lookup rather than a multiply per input.
+ */
+void IOBrain::setupBinaryBlocks()
+{
+    m_binaryBlocks.clear();
+    m_blockSums.clear();
+    m_groupBlocks.clear();
+    for (const SensorGroup &group : m_sensorGroups)
     {
-       m_outputs[j].average(otherBrain->m_outputs[j]);
+        std::pair<uint, uint> groupBlocks(m_binaryBlocks.size(), 0);
+        if (group.maxValue == 1)
+        {
+            uint lastInput = group.firstInput + group.numInputs;
+            for (uint first = group.firstInput; first < lastInput; first += BinaryBlockSize)
+            {
+                BinaryBlock block;
+                block.firstInput = first;
+                block.numInputs = std::min(BinaryBlockSize, lastInput - first);
+                m_binaryBlocks.push_back(block);
+                groupBlocks.second++;
+
+                for (uint pattern = 0; pattern < (1u << BinaryBlockSize); pattern++)
+                {
+                    for (int j = 0; j < 2; j++)
+                    {
+                        int sum = 0;
+                        for (uint b = 0; b < block.numInputs; b++)
+                        {
+                            if (pattern & (1 << b)) sum += inputWeight(j, first + b);
+                        }
+                        m_blockSums.push_back(sum);
+                    }
+                }
+            }
+        }
+        m_groupBlocks.push_back(groupBlocks);
     }
+    m_blocksValid = true;
 }
 
-void IOBrain::mix(Brain *other)
+/**
+ * @brief Add what the inputs of one sensor group give to the outputs
+ *
+ * setupBinaryBlocks must have been called since the weights last changed
+ *
+ * @param group index of the group
+ * @param sums left and right sums to add to
+ */
+void IOBrain::addGroupSums(uint group, long long *sums) const
 {
-    IOBrain *otherBrain = dynamic_cast<IOBrain *>(other);
-    if (otherBrain == nullptr) return; // Can only work with another SimpleBrain
+    const std::pair<uint, uint> &groupBlocks = m_groupBlocks[group];
+    if (groupBlocks.second > 0)
+    {
+        for (uint b = groupBlocks.first; b < groupBlocks.first + groupBlocks.second; b++)
+        {
+            const BinaryBlock &block = m_binaryBlocks[b];
+            const int *inputs = m_inputs + block.firstInput;
+            uint pattern = 0;
+            for (uint k = 0; k < block.numInputs; k++) pattern |= (inputs[k] != 0) << k;
+            const int *blockSums = m_blockSums.data() + (b << BinaryBlockSize) * 2 + pattern * 2;
+            sums[0] += blockSums[0];
+            sums[1] += blockSums[1];
+        }
+    } else
+    {
+        const SensorGroup &sensorGroup = m_sensorGroups[group];
+        const int *weights = m_weights->data();
+        for (uint k = sensorGroup.firstInput; k < sensorGroup.firstInput + sensorGroup.numInputs; k++)
+        {
+            sums[0] += (long long)weights[2 * k] * m_inputs[k];
+            sums[1] += (long long)weights[2 * k + 1] * m_inputs[k];
+        }
+    }
+}
 
-    for (int j = 0; j < 2; j++)
+/**
+ * @brief Fill all the sensor groups
+ * @param pt The head position of the worm
+ * @param dir the direction the worm is facing
+ */
+void IOBrain::fillInputs(QPoint pt, int dir)
+{
+    for (uint group = 0; group < m_sensorGroups.size(); group++)
     {
-       m_outputs[j].mix(otherBrain->m_outputs[j]);
+        fillSensorGroup(group, pt, dir);
     }
 }
 
-void IOBrain::randomise(int chance, int weight)
+/**
+ * @brief Fill one sensor group
+ *
+ * Must be overridden by brains that add sensor groups
+ */
+void IOBrain::fillSensorGroup(uint group, QPoint pt, int dir)
+{
+    Q_UNUSED(group)
+    Q_UNUSED(pt)
+    Q_UNUSED(dir)
+    Q_ASSERT(false);
+}
+
+/**
+ * @brief Add a group of inputs filled by one sensor call
+ *
+ * The group starts after the last group added
+ *
+ * @param numInputs number of inputs in the group
+ * @param maxValue maximum value of any of the inputs or UnboundedInput
+ */
+void IOBrain::addSensorGroup(uint numInputs, int maxValue)
+{
+    SensorGroup group;
+    group.firstInput = m_sensorGroups.empty() ? 0 : m_sensorGroups.back().firstInput + m_sensorGroups.back().numInputs;
+    group.numInputs = numInputs;
+    group.maxValue = maxValue;
+    Q_ASSERT(group.firstInput + numInputs <= m_numInputs);
+    m_sensorGroups.push_back(group);
+}
+
+/**
+ * @brief Work out the order to sense the groups in for lazy sensing
+ *
+ * All inputs lie between 0 and the maximum value of their group, so the
+ * range each group can add to an output is known before it is sensed.
+ * The groups that can change the outputs the most are sensed first.
+ */
+void IOBrain::setupLazySensing()
 {
     for (int j = 0; j < 2; j++)
     {
-        m_outputs[j].randomise(chance, weight);
+        m_lazyHigh[j] = m_lazyLow[j] = 0;
+        m_lazyUnbounded[j] = 0;
+    }
+
+    m_lazyGroups.clear();
+    for (uint g = 0; g < m_sensorGroups.size(); g++)
+    {
+        const SensorGroup &group = m_sensorGroups[g];
+        LazyGroup lazyGroup;
+        lazyGroup.group = g;
+        lazyGroup.potential = 0;
+        for (int j = 0; j < 2; j++)
+        {
+            long long high = 0, low = 0;
+            bool hasWeight = false;
+            for (uint k = group.firstInput; k < group.firstInput + group.numInputs; k++)
+            {
+                long long contribution = (long long)inputWeight(j, k) * group.maxValue;
+                if (contribution > 0) high += contribution;
+                else low += contribution;
+                if (inputWeight(j, k)) hasWeight = true;
+            }
+            lazyGroup.unbounded[j] = (group.maxValue == UnboundedInput && hasWeight);
+            if (lazyGroup.unbounded[j])
+            {
+                m_lazyUnbounded[j]++;
+                high = low = 0;
+                lazyGroup.potential = LLONG_MAX;
+            } else if (lazyGroup.potential != LLONG_MAX)
+            {
+                lazyGroup.potential += high - low;
+            }
+            lazyGroup.high[j] = high;
+            lazyGroup.low[j] = low;
+            m_lazyHigh[j] += high;
+            m_lazyLow[j] += low;
+        }
+        m_lazyGroups.push_back(lazyGroup);
+    }
+
+    std::stable_sort(m_lazyGroups.begin(), m_lazyGroups.end(),
+                     [](const LazyGroup &a, const LazyGroup &b) {return a.potential > b.potential;});
+    m_lazyValid = true;
+}
+
+/**
+ * @brief Calculate the sign of the outputs using as few sensors as possible
+ *
+ * Groups are sensed in the order set up by setupLazySensing and stop as
+ * soon as the sign of both outputs can no longer change.
+ *
+ * The result is always the same as filling all the inputs.
+ *
+ * @param pt The head position of the worm
+ * @param dir the direction the worm is facing
+ * @param left set to true if the left output is positive
+ * @param right set to true if the right output is positive
+ */
+void IOBrain::lazyOutputs(QPoint pt, int dir, bool &left, bool &right)
+{
+    if (!m_lazyValid) setupLazySensing();
+    if (!m_blocksValid) setupBinaryBlocks();
+
+    long long sum[2] = {0, 0};
+    long long high[2] = {m_lazyHigh[0], m_lazyHigh[1]};
+    long long low[2] = {m_lazyLow[0], m_lazyLow[1]};
+    int unbounded[2] = {m_lazyUnbounded[0], m_lazyUnbounded[1]};
+
+    for (const LazyGroup &lazyGroup : m_lazyGroups)
+    {
+        bool decided = true;
+        for (int j = 0; j < 2 && decided; j++)
+        {
+            decided = (unbounded[j] == 0 && (sum[j] + low[j] > 0 || sum[j] + high[j] <= 0));
+        }
+        if (decided) break;
+
+        fillSensorGroup(lazyGroup.group, pt, dir);
+        addGroupSums(lazyGroup.group, sum);
+        for (int j = 0; j < 2; j++)
+        {
+            high[j] -= lazyGroup.high[j];
+            low[j] -= lazyGroup.low[j];
+            if (lazyGroup.unbounded[j]) unbounded[j]--;
+        }
+    }
+
+    // When a sign is decided sum + low has the same sign as every possible total
+    left = (sum[0] + low[0] > 0);
+    right = (sum[1] + low[1] > 0);
+}
+
+/**
+ * @brief Set up an empty decision table if the brain can use one
+ *
+ * A brain whose sensor groups are all binary, with no more than
+ * MaxDecisionBits inputs, makes a decision that only depends on the
+ * pattern of inputs it has sensed. Groups are sensed in the lazy
+ * sensing order, and after each group the pattern so far is looked up
+ * in the table for that number of groups. The entry says whether the
+ * move is decided or another group needs to be sensed. Entries are
+ * worked out the first time a pattern is seen, so only the patterns the
+ * worm meets are ever calculated. Once the tables of all the brains
+ * add up to MaxDecisionTableBytes new brains go without one. A brain
+ * that has been copied into reuses the table it had.
+ */
+void IOBrain::setupDecisionTable()
+{
+    m_useDecisions = (!m_sensorGroups.empty() && m_numInputs <= MaxDecisionBits);
+    for (const SensorGroup &group : m_sensorGroups)
+    {
+        if (group.maxValue != 1) m_useDecisions = false;
+    }
+
+    m_decisionOffsets.clear();
+    if (m_useDecisions)
+    {
+        if (!m_lazyValid) setupLazySensing();
+        if (!m_blocksValid) setupBinaryBlocks();
+        uint size = 0, bits = 0;
+        m_decisionOffsets.push_back(size);
+        size += 1;
+        for (const LazyGroup &lazyGroup : m_lazyGroups)
+        {
+            bits += m_sensorGroups[lazyGroup.group].numInputs;
+            m_decisionOffsets.push_back(size);
+            size += 1 << bits;
+        }
+        size_t held = m_decisions.capacity();
+        if (s_decisionTableBytes - held + size > MaxDecisionTableBytes)
+        {
+            // Big populations fall back to deciding every move
+            m_useDecisions = false;
+        } else
+        {
+            m_decisions.assign(size, DecisionUnknown);
+            s_decisionTableBytes += m_decisions.capacity() - held;
+        }
+    }
+    if (!m_useDecisions) releaseDecisionTable();
+    m_decisionsValid = true;
+}
+
+/**
+ * @brief Free the decision table and take it out of the total for all brains
+ */
+void IOBrain::releaseDecisionTable()
+{
+    s_decisionTableBytes -= m_decisions.capacity();
+    PoolVector<unsigned char>().swap(m_decisions);
+}
+
+/**
+ * @brief Work out the decision for the inputs sensed so far
+ *
+ * The inputs of the first numSensed groups in the lazy order must be set.
+ *
+ * @param numSensed number of groups sensed
+ * @return DecisionSenseMore or DecisionMade with the output flags
+ */
+unsigned char IOBrain::decide(uint numSensed) const
+{
+    long long sum[2] = {0, 0};
+    long long high[2] = {m_lazyHigh[0], m_lazyHigh[1]};
+    long long low[2] = {m_lazyLow[0], m_lazyLow[1]};
+    for (uint g = 0; g < numSensed; g++)
+    {
+        const LazyGroup &lazyGroup = m_lazyGroups[g];
+        addGroupSums(lazyGroup.group, sum);
+        for (int j = 0; j < 2; j++)
+        {
+            high[j] -= lazyGroup.high[j];
+            low[j] -= lazyGroup.low[j];
+        }
+    }
+
+    if (numSensed < m_lazyGroups.size())
+    {
+        if (!s_lazySensing) return DecisionSenseMore;
+        for (int j = 0; j < 2; j++)
+        {
+            if (sum[j] + low[j] <= 0 && sum[j] + high[j] > 0) return DecisionSenseMore;
+        }
+    }
+
+    unsigned char decision = DecisionMade;
+    if (sum[0] + low[0] > 0) decision |= DecisionLeft;
+    if (sum[1] + low[1] > 0) decision |= DecisionRight;
+    return decision;
+}
+
+/**
+ * @brief Calculate the sign of the outputs from the decision table
+ *
+ * Gives the same result as lazyOutputs and, once a pattern has been
+ * seen, only senses the groups and looks up the table.
+ *
+ * @param pt The head position of the worm
+ * @param dir the direction the worm is facing
+ * @param left set to true if the left output is positive
+ * @param right set to true if the right output is positive
+ */
+void IOBrain::tableOutputs(QPoint pt, int dir, bool &left, bool &right)
+{
+    uint pattern = 0;
+    for (uint numSensed = 0; ; numSensed++)
+    {
+        unsigned char &decision = m_decisions[m_decisionOffsets[numSensed] + pattern];
+        if (decision == DecisionUnknown) decision = decide(numSensed);
+        if (decision & DecisionMade)
+        {
+            left = (decision & DecisionLeft) != 0;
+            right = (decision & DecisionRight) != 0;
+            return;
+        }
+
+        const SensorGroup &group = m_sensorGroups[m_lazyGroups[numSensed].group];
+        fillSensorGroup(m_lazyGroups[numSensed].group, pt, dir);
+        for (uint k = group.firstInput; k < group.firstInput + group.numInputs; k++)
+        {
+            pattern = (pattern << 1) | (m_inputs[k] != 0);
+        }
     }
 }
 
+void IOBrain::average(Brain *other)
+{
+    IOBrain *otherBrain = dynamic_cast<IOBrain *>(other);
+    if (otherBrain == nullptr) return; // Can only work with another SimpleBrain
+
+    // Averaging shared weights with themselves changes nothing
+    if (m_weights == otherBrain->m_weights) return;
+
+    // Weights with no match in the other brain are averaged with 0
+    Weights &weights = ownWeights();
+    uint common = std::min(weights.size(), otherBrain->m_weights->size());
+    averageGenes(weights.data(), otherBrain->m_weights->data(), common);
+    for (uint k = common; k < weights.size(); k++) weights[k] /= 2;
+    weightsChanged();
+}
+
+void IOBrain::mix(Brain *other)
+{
+    IOBrain *otherBrain = dynamic_cast<IOBrain *>(other);
+    if (otherBrain == nullptr) return; // Can only work with another SimpleBrain
+
+    if (m_weights == otherBrain->m_weights) return;
+
+    Weights &weights = ownWeights();
+    uint common = std::min(weights.size(), otherBrain->m_weights->size());
+    mixGenes(weights.data(), otherBrain->m_weights->data(), common);
+    weightsChanged();
+}
+
+void IOBrain::randomise(int chance, int weight)
+{
+    const PoolVector<GeneChange> &changes = pickMutations(m_weights->size(), chance, weight);
+    // Keep sharing the weights if nothing changed
+    if (changes.empty()) return;
+
+    Weights &weights = ownWeights();
+    for (auto change : changes) weights[change.gene] += change.change;
+    weightsChanged();
+}
+
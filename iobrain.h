@@ -2,11 +2,23 @@
 #define IOBRAIN_H
 
 #include "brain.h"
-#include "braincell.h"
+#include <vector>
+#include <memory>
+#include <atomic>
 
 /**
  * @brief Simple base class for a brain with multiple inputs
  * attached to two outputs
+ *
+ * The inputs are held in a plain int array. The weights for the two
+ * outputs are interleaved, input by input, so both outputs are worked
+ * out in a single pass over the inputs.
+ *
+ * Copies of a brain share the same weights until one of them changes
+ * its weights, so children that are not mutated cost no new storage.
+ * A brain that is copied into keeps its old weights to reuse the next
+ * time it needs its own. The inputs, weights and the tables cached
+ * from them all come from the MemoryPool.
  */
 class IOBrain : public Brain
 {
@@ -15,28 +27,149 @@ public:
     IOBrain(const IOBrain &other, Worm *worm);
     virtual ~IOBrain();
 
+    virtual bool copyFrom(const Brain &other);
+
     virtual void write(QDataStream &out);
     virtual void read(QDataStream &in);
+    virtual void memoryUsage(MemoryUsage &usage) const;
 
     virtual void planMove(QPoint &pt, int &dir);
 
     virtual void randomise(int chance, int weight);
     virtual void average(Brain *other);
     virtual void mix(Brain *other);
+    virtual const int *genome(uint &count) const {count = m_weights->size(); return m_weights->data();}
+
+    static bool lazySensing() {return s_lazySensing;}
+    static void setLazySensing(bool lazy) {s_lazySensing = lazy;}
+    static bool decisionTables() {return s_decisionTables;}
+    static void setDecisionTables(bool tables) {s_decisionTables = tables;}
 
+    /**
+     * @brief maximum value used for inputs that count things and so have no fixed limit
+     */
+    static const int UnboundedInput = -1;
 
 protected:
+    typedef PoolVector<int> Weights;
+
     /**
      * @brief Fill the inputs with the data from the worms sensors
+     *
+     * The default calls fillSensorGroup for every sensor group
+     *
      * @param pt The head position of the worm
      * @param dir the direction the worm is facing
      */
-    virtual void fillInputs(QPoint pt, int dir) = 0;
+    virtual void fillInputs(QPoint pt, int dir);
+
+    /**
+     * @brief Fill the inputs for one sensor group
+     * @param group index of group to fill
+     * @param pt The head position of the worm
+     * @param dir the direction the worm is facing
+     */
+    virtual void fillSensorGroup(uint group, QPoint pt, int dir);
+
+    void outputValues(long long &left, long long &right);
+
+    /**
+     * @brief Weight linking an input to an output
+     * @param output 0 for left or 1 for right
+     * @param input index of the input
+     */
+    inline int inputWeight(int output, uint input) const {return (*m_weights)[input * 2 + output];}
+    inline void setInputWeight(int output, uint input, int weight) {ownWeights()[input * 2 + output] = weight;}
+
+    const Weights &weights() const {return *m_weights;}
+    Weights &ownWeights();
+
+    void resizeInputs(uint numInputs);
+    void addSensorGroup(uint numInputs, int maxValue);
+    void weightsChanged() {m_lazyValid = m_blocksValid = m_decisionsValid = false;}
+    void setupBinaryBlocks();
+    void addGroupSums(uint group, long long *sums) const;
+    void setupLazySensing();
+    void lazyOutputs(QPoint pt, int dir, bool &left, bool &right);
+    void setupDecisionTable();
+    void releaseDecisionTable();
+    unsigned char decide(uint numSensed) const;
+    void tableOutputs(QPoint pt, int dir, bool &left, bool &right);
+
+    /**
+     * @brief Block of inputs that are filled by a single sensor call
+     */
+    struct SensorGroup
+    {
+        uint firstInput;
+        uint numInputs;
+        int maxValue; // Largest value of an input or UnboundedInput
+    };
+
+    /**
+     * @brief Up to 4 inputs of a binary sensor group packed into one table index
+     */
+    struct BinaryBlock
+    {
+        uint firstInput;
+        uint numInputs;
+    };
+    static const uint BinaryBlockSize = 4;
+
+    /**
+     * @brief Range a sensor group can add to each output
+     */
+    struct LazyGroup
+    {
+        uint group;
+        long long high[2];
+        long long low[2];
+        bool unbounded[2];
+        long long potential; // Most the group can change the outputs by, LLONG_MAX if unbounded
+    };
 
 protected:
     uint m_numInputs;
-    InputBrainCell *m_inputs;
-    LinkedBrainCell m_outputs[2];
+    int *m_inputs;
+    std::shared_ptr<Weights> m_weights; // Left and right output weights for each input in turn
+    PoolVector<SensorGroup> m_sensorGroups;
+
+private:
+    uint m_inputCapacity;
+    std::shared_ptr<Weights> m_spareWeights; // Weights kept from before the brain was copied into
+
+    // Cached from the weights for binary sensor groups
+    bool m_blocksValid;
+    PoolVector<BinaryBlock> m_binaryBlocks;
+    PoolVector<int> m_blockSums; // Left and right sums for every bit pattern of each block
+    PoolVector<std::pair<uint, uint> > m_groupBlocks; // First block and number of blocks for each group
+
+    // Cached from the weights for lazy sensing
+    bool m_lazyValid;
+    PoolVector<LazyGroup> m_lazyGroups; // In the order they are sensed
+    long long m_lazyHigh[2];
+    long long m_lazyLow[2];
+    int m_lazyUnbounded[2];
+
+    // Decisions remembered for each pattern of sensed inputs
+    static const uint MaxDecisionBits = 16;
+    static const size_t MaxDecisionTableBytes = 256 * 1024 * 1024; // For all brains together
+    static std::atomic<size_t> s_decisionTableBytes; // Tables are set up while planning moves on several threads
+    enum DecisionFlags
+    {
+        DecisionUnknown = 0,
+        DecisionSenseMore = 1,
+        DecisionMade = 2,
+        DecisionLeft = 4,
+        DecisionRight = 8
+    };
+    bool m_decisionsValid;
+    bool m_useDecisions;
+    PoolVector<unsigned char> m_decisions;
+    PoolVector<uint> m_decisionOffsets; // Start of the table for each number of groups sensed
+
+    static bool s_lazySensing;
+    static bool s_decisionTables;
 };
 
 #endif // IOBRAIN_H
@@ -6,11 +6,20 @@
 #include "wormtank.h"
 #include "wormtankmodelview.h"
 #include "trendchart.h"
+#include "benchmark.h"
 
 int main(int argc, char *argv[])
 {
     QApplication app(argc, argv);
 
+    // --benchmark [wormType] runs tanks without the window and prints their speed
+    int benchmarkArg = app.arguments().indexOf("--benchmark");
+    if (benchmarkArg >= 0)
+    {
+        QString wormType = app.arguments().value(benchmarkArg + 1, "SimpleWithNextTo");
+        return Benchmark(wormType).run();
+    }
+
     qmlRegisterType<TrendChart>("WormTank", 1, 0, "TrendChart");
 
     QQmlApplicationEngine engine;
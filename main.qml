@@ -78,6 +78,10 @@ ApplicationWindow {
                 text : qsTr("&Generations")
                 onTriggered: wormTankModelView.viewGeneration()
             }
+            MenuItem {
+                text : qsTr("&Memory")
+                onTriggered: wormTankModelView.viewMemory()
+            }
         }
         Menu {
             title: qsTr("Help")
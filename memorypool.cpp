@@ -0,0 +1,75 @@
+#include "memorypool.h"
+#include <QMutexLocker>
+#include <new>
+
+QMutex MemoryPool::s_mutex;
+std::vector<void *> MemoryPool::s_freeBlocks[MemoryPool::MaxPooledSize / MemoryPool::Granularity];
+char *MemoryPool::s_chunkPos = nullptr;
+char *MemoryPool::s_chunkEnd = nullptr;
+uint MemoryPool::s_allocations = 0;
+size_t MemoryPool::s_allocatedBytes = 0;
+
+/**
+ * @brief Allocate a block
+ *
+ * The size is rounded up to a multiple of Granularity so every block
+ * is aligned for any type.
+ *
+ * @param size number of bytes needed
+ * @return the block
+ */
+void *MemoryPool::allocate(size_t size)
+{
+    QMutexLocker lock(&s_mutex);
+    s_allocations++;
+    s_allocatedBytes += size;
+    if (size == 0) size = 1;
+    if (size > MaxPooledSize) return ::operator new(size);
+
+    std::vector<void *> &freeBlocks = s_freeBlocks[(size - 1) / Granularity];
+    if (!freeBlocks.empty())
+    {
+        void *block = freeBlocks.back();
+        freeBlocks.pop_back();
+        return block;
+    }
+
+    size_t blockSize = ((size - 1) / Granularity + 1) * Granularity;
+    if (size_t(s_chunkEnd - s_chunkPos) < blockSize)
+    {
+        // The rest of the old chunk is too small to use and is left
+        s_chunkPos = static_cast<char *>(::operator new(ChunkSize));
+        s_chunkEnd = s_chunkPos + ChunkSize;
+    }
+    void *block = s_chunkPos;
+    s_chunkPos += blockSize;
+    return block;
+}
+
+/**
+ * @brief Give a block back to the pool
+ * @param ptr block to release, may be nullptr
+ * @param size size that was asked for when it was allocated
+ */
+void MemoryPool::release(void *ptr, size_t size)
+{
+    if (ptr == nullptr) return;
+    QMutexLocker lock(&s_mutex);
+    if (size == 0) size = 1;
+    if (size > MaxPooledSize)
+    {
+        ::operator delete(ptr);
+        return;
+    }
+    s_freeBlocks[(size - 1) / Granularity].push_back(ptr);
+}
+
+/**
+ * @brief Start counting allocations again from 0
+ */
+void MemoryPool::resetCounts()
+{
+    QMutexLocker lock(&s_mutex);
+    s_allocations = 0;
+    s_allocatedBytes = 0;
+}
@@ -0,0 +1,72 @@
+#ifndef MEMORYPOOL_H
+#define MEMORYPOOL_H
+
+#include <QtGlobal>
+#include <QMutex>
+#include <cstddef>
+#include <vector>
+
+/**
+ * @brief Pool for the small objects that are made and thrown away every generation
+ *
+ * Worms, their bodies, their brains and the inputs, weights and tables
+ * the brains keep are allocated from here, so the allocation counts
+ * cover all of them. Blocks are handed out of large chunks by moving a
+ * pointer along, and freed blocks are kept on a list for their size so
+ * the next generation's children reuse the memory of the worms that
+ * died. Once a tank is running the heap is rarely touched.
+ *
+ * Blocks larger than MaxPooledSize go straight to the heap.
+ *
+ * Brains build some of their tables the first time they plan a move,
+ * which can be on the planner threads, so the pool is locked.
+ */
+class MemoryPool
+{
+public:
+    static void *allocate(size_t size);
+    static void release(void *ptr, size_t size);
+
+    /**
+     * @brief Number of allocations since the counts were last reset
+     */
+    static uint allocations() {return s_allocations;}
+    /**
+     * @brief Number of bytes allocated since the counts were last reset
+     */
+    static size_t allocatedBytes() {return s_allocatedBytes;}
+    static void resetCounts();
+
+private:
+    static const size_t Granularity = 16;
+    static const size_t MaxPooledSize = 512;
+    static const size_t ChunkSize = 64 * 1024;
+
+    static QMutex s_mutex;
+    static std::vector<void *> s_freeBlocks[MaxPooledSize / Granularity];
+    static char *s_chunkPos;
+    static char *s_chunkEnd;
+    static uint s_allocations;
+    static size_t s_allocatedBytes;
+};
+
+/**
+ * @brief Allocator for containers whose storage should come from the pool
+ */
+template<class T> struct PoolAllocator
+{
+    typedef T value_type;
+
+    PoolAllocator() {}
+    template<class U> PoolAllocator(const PoolAllocator<U> &) {}
+
+    T *allocate(size_t count) {return static_cast<T *>(MemoryPool::allocate(count * sizeof(T)));}
+    void deallocate(T *ptr, size_t count) {MemoryPool::release(ptr, count * sizeof(T));}
+};
+
+template<class T, class U> inline bool operator==(const PoolAllocator<T> &, const PoolAllocator<U> &) {return true;}
+template<class T, class U> inline bool operator!=(const PoolAllocator<T> &, const PoolAllocator<U> &) {return false;}
+
+template<class T> using PoolVector = std::vector<T, PoolAllocator<T> >;
+
+#endif // MEMORYPOOL_H
@@ -0,0 +1,154 @@
+#include "memoryusage.h"
+#include <algorithm>
+
+static const char *AreaNames[MemoryUsage::NumAreas] =
+{
+    "Tank grid",
+    "Food",
+    "Worms",
+    "Worm bodies",
+    "Brains",
+    "Brain weights",
+    "Sensor programs",
+    "Brain memories",
+    "Indexes",
+    "History",
+    "Move costs"
+};
+
+MemoryUsage::MemoryUsage(QObject *parent) : QAbstractListModel(parent)
+{
+    std::fill(m_bytes, m_bytes + NumAreas, 0);
+    clearPeaks();
+}
+
+/**
+ * @brief Start adding up the bytes again from 0
+ */
+void MemoryUsage::start()
+{
+    std::fill(m_bytes, m_bytes + NumAreas, 0);
+    m_sharedBlocks.clear();
+}
+
+/**
+ * @brief Add a block that may be shared, only counting it the first time
+ * @param area area the block belongs to
+ * @param block address of the block, or nullptr for none
+ * @param bytes size of the block
+ */
+void MemoryUsage::addShared(Area area, const void *block, size_t bytes)
+{
+    if (block != nullptr && m_sharedBlocks.insert(block).second) m_bytes[area] += bytes;
+}
+
+/**
+ * @brief Move bytes already added to one area to another
+ *
+ * Used for storage that is inside an object counted as a whole.
+ *
+ * @param from area the bytes were added to
+ * @param to area they should be shown in
+ * @param bytes number of bytes to move
+ */
+void MemoryUsage::transfer(Area from, Area to, size_t bytes)
+{
+    bytes = std::min(bytes, m_bytes[from]);
+    m_bytes[from] -= bytes;
+    m_bytes[to] += bytes;
+}
+
+/**
+ * @brief Finish adding up, update the peaks and show the new values
+ */
+void MemoryUsage::finish()
+{
+    for (int j = 0; j < NumAreas; j++) m_peakBytes[j] = std::max(m_peakBytes[j], m_bytes[j]);
+    m_peakTotalBytes = std::max(m_peakTotalBytes, totalBytes());
+    emit dataChanged(index(0), index(NumAreas));
+}
+
+/**
+ * @brief Forget the peaks, e.g. when a new tank is started
+ */
+void MemoryUsage::clearPeaks()
+{
+    std::fill(m_peakBytes, m_peakBytes + NumAreas, 0);
+    m_peakTotalBytes = 0;
+}
+
+/**
+ * @brief Get the bytes used by all the areas
+ */
+size_t MemoryUsage::totalBytes() const
+{
+    size_t total = 0;
+    for (int j = 0; j < NumAreas; j++) total += m_bytes[j];
+    return total;
+}
+
+/**
+ * @brief Return role names for QML
+ * @return role names with has to id
+ */
+QHash<int, QByteArray> MemoryUsage::roleNames() const
+{
+    QHash<int, QByteArray> roles = QAbstractListModel::roleNames();
+    roles.insert(NameRole, QByteArray("name"));
+    roles.insert(KBytesRole, QByteArray("kBytes"));
+    roles.insert(PeakKBytesRole, QByteArray("peakKBytes"));
+
+    return roles;
+}
+
+/**
+ * @brief return the data for the role
+ * @param index row index
+ * @param role role to return data for
+ * @return variant with correct data, sizes in KB rounded up
+ */
+QVariant MemoryUsage::data(const QModelIndex & index, int role) const
+{
+    if (!index.isValid())
+        return QVariant();
+
+    if (role < NameRole || role > PeakKBytesRole)
+        return QVariant();
+
+    int row = index.row();
+    bool total = (row == NumAreas);
+    switch(Roles(role))
+    {
+    case NameRole: return total ? QString("Total") : QString(AreaNames[row]); break;
+    case KBytesRole: return uint(((total ? totalBytes() : m_bytes[row]) + 1023) / 1024); break;
+    case PeakKBytesRole: return uint(((total ? m_peakTotalBytes : m_peakBytes[row]) + 1023) / 1024); break;
+    }
+    return QVariant();
+}
+
+/**
+ * @brief Return headerData for a role
+ * @param section row or column
+ * @param orientation direction required
+ * @param role role name
+ * @return Header text
+ */
+QVariant MemoryUsage::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if (role != Qt::DisplayRole)
+            return QVariant();
+    if (orientation == Qt::Horizontal)
+    {
+        switch(Roles(section))
+        {
+        case NameRole: return "Area"; break;
+        case KBytesRole: return "KB"; break;
+        case PeakKBytesRole: return "Peak KB"; break;
+        }
+    } else
+    {
+        return section+1;
+    }
+
+    return QVariant();
+}
@@ -0,0 +1,78 @@
+#ifndef MEMORYUSAGE_H
+#define MEMORYUSAGE_H
+
+#include <QObject>
+#include <QAbstractListModel>
+#include <unordered_set>
+#include <vector>
+
+/**
+ * @brief Bytes used by each part of a tank
+ *
+ * The tank adds up what each part is using at the end of every
+ * generation between start() and finish(), and the largest total seen
+ * for each part is kept as its peak. Blocks shared between brains are
+ * added with addShared so they are only counted once.
+ *
+ * There is a row for each area and a last row for the total.
+ */
+class MemoryUsage : public QAbstractListModel
+{
+    Q_OBJECT
+public:
+    explicit MemoryUsage(QObject *parent = 0);
+
+    enum Area
+    {
+        Grid,
+        Food,
+        Worms,
+        Bodies,
+        Brains,
+        Weights,
+        Sensors,
+        Memories,
+        Indexes,
+        History,
+        MoveCosts,
+        NumAreas
+    };
+
+    void start();
+    void add(Area area, size_t bytes) {m_bytes[area] += bytes;}
+    void addShared(Area area, const void *block, size_t bytes);
+    void transfer(Area from, Area to, size_t bytes);
+    void finish();
+    void clearPeaks();
+
+    size_t bytes(Area area) const {return m_bytes[area];}
+    size_t peakBytes(Area area) const {return m_peakBytes[area];}
+    size_t totalBytes() const;
+    size_t peakTotalBytes() const {return m_peakTotalBytes;}
+
+    /**
+     * @brief Get the bytes allocated for the elements of a vector
+     */
+    template<class T, class A> static size_t vectorBytes(const std::vector<T, A> &items) {return items.capacity() * sizeof(T);}
+
+    enum Roles
+    {
+       NameRole = Qt::UserRole + 0,
+       KBytesRole,
+       PeakKBytesRole
+    };
+
+    // Abstract table model overrides
+    int rowCount(const QModelIndex &/*parent = QModelIndex()*/) const {return NumAreas + 1;}
+    QHash<int, QByteArray> roleNames() const;
+    QVariant data(const QModelIndex & index, int role = Qt::DisplayRole) const;
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const;
+
+private:
+    size_t m_bytes[NumAreas];
+    size_t m_peakBytes[NumAreas];
+    size_t m_peakTotalBytes;
+    std::unordered_set<const void *> m_sharedBlocks; // Shared blocks already added since start()
+};
+
+#endif // MEMORYUSAGE_H
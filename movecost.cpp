@@ -0,0 +1,140 @@
+#include "movecost.h"
+#include <algorithm>
+
+// Time every move, the timer costs much less than most brains
+bool MoveCosts::s_enabled = true;
+
+/**
+ * @brief Add the moves from another histogram
+ * @param other histogram to add
+ */
+void MoveCost::add(const MoveCost &other)
+{
+    for (uint j = 0; j < NumBuckets; j++) m_buckets[j] += other.m_buckets[j];
+    m_moves += other.m_moves;
+    m_totalNsecs += other.m_totalNsecs;
+}
+
+/**
+ * @brief Remove all the moves
+ */
+void MoveCost::clear()
+{
+    std::fill(m_buckets, m_buckets + NumBuckets, 0);
+    m_moves = 0;
+    m_totalNsecs = 0;
+}
+
+/**
+ * @brief Get the time that a percentage of the moves took no longer than
+ * @param percent percentage of moves, e.g. 50 for the median
+ * @return time in nanoseconds, rounded down to the start of its bucket
+ */
+quint64 MoveCost::percentile(uint percent) const
+{
+    if (m_moves == 0) return 0;
+    quint64 needed = (quint64(m_moves) * percent + 99) / 100;
+    if (needed == 0) needed = 1;
+    quint64 found = 0;
+    for (uint j = 0; j < NumBuckets; j++)
+    {
+        found += m_buckets[j];
+        if (found >= needed) return bucketStart(j);
+    }
+    return bucketStart(NumBuckets - 1);
+}
+
+/**
+ * @brief Get the smallest time that goes in a bucket
+ */
+quint64 MoveCost::bucketStart(uint bucket)
+{
+    if (bucket < LinearBuckets) return bucket;
+    uint exponent = (bucket - LinearBuckets) / 16 + 4;
+    return quint64(16 + (bucket - LinearBuckets) % 16) << (exponent - 4);
+}
+
+/**
+ * @brief Get the histogram to add moves to for a brain
+ *
+ * The histogram stays at the same address for the life of the tank
+ * so a worm only has to look it up once.
+ *
+ * @param fullName full name of the brain
+ * @param typeName name of the brain type
+ * @return histogram for the current generation
+ */
+MoveCost *MoveCosts::costFor(const std::string &fullName, const std::string &typeName)
+{
+    Entry &entry = m_entries[fullName];
+    entry.typeName = typeName;
+    return &entry.current;
+}
+
+/**
+ * @brief Keep the costs of the generation that has finished and start again
+ */
+void MoveCosts::endGeneration()
+{
+    for (auto &item : m_entries)
+    {
+        item.second.last = item.second.current;
+        item.second.current.clear();
+    }
+}
+
+/**
+ * @brief Remove all the costs
+ *
+ * The entries are kept as worms may still point at them.
+ */
+void MoveCosts::clear()
+{
+    for (auto &item : m_entries)
+    {
+        item.second.last.clear();
+        item.second.current.clear();
+    }
+}
+
+/**
+ * @brief Get an estimate of the bytes used by the entries
+ *
+ * Allows for the map node and the names but not the heap's own overhead.
+ */
+size_t MoveCosts::memoryBytes() const
+{
+    size_t bytes = 0;
+    for (auto &item : m_entries)
+    {
+        bytes += sizeof(item) + 4 * sizeof(void *); // Map node with its links
+        bytes += item.first.capacity() + item.second.typeName.capacity();
+    }
+    return bytes;
+}
+
+/**
+ * @brief Get the costs in the last generation for a brain full name
+ * @param fullName full name of the brain
+ * @return costs or nullptr if the brain has never been run
+ */
+const MoveCost *MoveCosts::lastCost(const std::string &fullName) const
+{
+    auto found = m_entries.find(fullName);
+    return (found == m_entries.end()) ? nullptr : &found->second.last;
+}
+
+/**
+ * @brief Get the costs in the last generation for all the brains of a type
+ * @param typeName name of the brain type
+ * @return combined costs
+ */
+MoveCost MoveCosts::lastTypeCost(const std::string &typeName) const
+{
+    MoveCost cost;
+    for (auto &item : m_entries)
+    {
+        if (item.second.typeName == typeName) cost.add(item.second.last);
+    }
+    return cost;
+}
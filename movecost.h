@@ -0,0 +1,92 @@
+#ifndef MOVECOST_H
+#define MOVECOST_H
+
+#include <QtGlobal>
+#include <map>
+#include <string>
+
+/**
+ * @brief Histogram of the time taken to plan moves
+ *
+ * Times are kept in buckets that are at most 1/16 of their value wide
+ * so the percentiles are within about 6% without keeping every time.
+ */
+class MoveCost
+{
+public:
+    MoveCost() {clear();}
+
+    /**
+     * @brief Add the time taken for one move
+     * @param nsecs time in nanoseconds
+     */
+    inline void add(quint64 nsecs)
+    {
+        m_buckets[bucket(nsecs)]++;
+        m_moves++;
+        m_totalNsecs += nsecs;
+    }
+
+    void add(const MoveCost &other);
+    void clear();
+
+    uint moves() const {return m_moves;}
+    quint64 totalNsecs() const {return m_totalNsecs;}
+    quint64 meanNsecs() const {return m_moves ? m_totalNsecs / m_moves : 0;}
+    quint64 percentile(uint percent) const;
+
+private:
+    static const uint LinearBuckets = 16;
+    static const uint MaxExponent = 32;
+    static const uint NumBuckets = LinearBuckets + (MaxExponent - 4) * 16;
+
+    static inline uint bucket(quint64 nsecs)
+    {
+        if (nsecs < LinearBuckets) return uint(nsecs);
+        uint exponent = 63 - __builtin_clzll(nsecs);
+        if (exponent >= MaxExponent) return NumBuckets - 1;
+        return LinearBuckets + (exponent - 4) * 16 + uint(nsecs >> (exponent - 4)) - 16;
+    }
+    static quint64 bucketStart(uint bucket);
+
+private:
+    uint m_buckets[NumBuckets];
+    uint m_moves;
+    quint64 m_totalNsecs;
+};
+
+/**
+ * @brief Move costs for every brain full name seen in a tank
+ *
+ * Costs are gathered for the generation that is running and kept for
+ * the last complete generation.
+ */
+class MoveCosts
+{
+public:
+    MoveCost *costFor(const std::string &fullName, const std::string &typeName);
+    void endGeneration();
+    void clear();
+
+    const MoveCost *lastCost(const std::string &fullName) const;
+    MoveCost lastTypeCost(const std::string &typeName) const;
+
+    size_t memoryBytes() const;
+
+    static bool enabled() {return s_enabled;}
+    static void setEnabled(bool enabled) {s_enabled = enabled;}
+
+private:
+    struct Entry
+    {
+        std::string typeName;
+        MoveCost current;
+        MoveCost last;
+    };
+    // A map so the costs handed out by costFor never move
+    std::map<std::string, Entry> m_entries;
+
+    static bool s_enabled;
+};
+
+#endif // MOVECOST_H
@@ -2,8 +2,10 @@
 #include "wormtank.h"
 #include "worm.h"
 #include "random.h"
-#include "braincell.h"
+#include "genome.h"
+#include "memoryusage.h"
 #include <sstream>
+#include <algorithm>
 
 // Register the simple brain creator
 BrainCreator<MutantBrain> g_mutantBrainCreator(
@@ -22,26 +24,72 @@ BrainCreator<MutantBrain> g_mutantBrainCreator(
 MutantBrain::MutantBrain(Worm *worm) :
     IOBrain(worm, 4),
     m_numSensors(0),
+    m_sensorCapacity(0),
     m_sensors(nullptr)
 {
-    m_numSensors = m_numInputs/4;
-    m_sensors = new Sensor[m_numSensors];
+    resizeSensors(m_numInputs/4);
     m_sensors[0] = randSensor();
+    setupSensorGroups();
 }
 
 MutantBrain::MutantBrain(const MutantBrain &other, Worm *worm)
     : IOBrain(other, worm),
-      m_sensors(nullptr)
+      m_numSensors(0),
+      m_sensorCapacity(0),
+      m_sensors(nullptr),
+      m_program(other.m_program)
 {
-    m_numSensors = other.m_numSensors;
-    m_sensors = new Sensor[m_numSensors];
-    for (uint j = 0; j < m_numSensors; j++)
-        m_sensors[j] = other.m_sensors[j];
+    resizeSensors(other.m_numSensors);
+    std::copy(other.m_sensors, other.m_sensors + m_numSensors, m_sensors);
 }
 
 MutantBrain::~MutantBrain()
 {
-    delete [] m_sensors;
+    MemoryPool::release(m_sensors, m_sensorCapacity * sizeof(Sensor));
+}
+
+/**
+ * @brief Make this brain a copy of another MutantBrain
+ *
+ * The sensor program is shared as it is by a clone.
+ *
+ * @param other brain to copy
+ * @return false if the other brain is a different type
+ */
+bool MutantBrain::copyFrom(const Brain &other)
+{
+    if (!IOBrain::copyFrom(other)) return false;
+    const MutantBrain &otherBrain = static_cast<const MutantBrain &>(other);
+
+    resizeSensors(otherBrain.m_numSensors);
+    std::copy(otherBrain.m_sensors, otherBrain.m_sensors + m_numSensors, m_sensors);
+    if (m_program != otherBrain.m_program)
+    {
+        if (m_program.use_count() == 1) m_spareProgram = std::move(m_program);
+        m_program = otherBrain.m_program;
+    }
+    return true;
+}
+
+/**
+ * @brief Change the number of sensors
+ *
+ * The buffer is only replaced if it is too small, keeping the sensors
+ * that were there.
+ *
+ * @param numSensors number of sensors
+ */
+void MutantBrain::resizeSensors(uint numSensors)
+{
+    if (numSensors > m_sensorCapacity)
+    {
+        Sensor *sensors = static_cast<Sensor *>(MemoryPool::allocate(numSensors * sizeof(Sensor)));
+        std::copy(m_sensors, m_sensors + m_numSensors, sensors);
+        MemoryPool::release(m_sensors, m_sensorCapacity * sizeof(Sensor));
+        m_sensors = sensors;
+        m_sensorCapacity = numSensors;
+    }
+    m_numSensors = numSensors;
 }
 
 
@@ -85,11 +133,14 @@ std::string MutantBrain::fullName() const
         case WormRange:  name << "Wr"; addRanges = true; break;
         case WallRange:  name << "Er"; addRanges = true; break;
         case FoodCount:  name << "Fc"; addRanges = true; break;
-        case WormCount:  name << "Fc"; addRanges = true; break;
+        case WormCount:  name << "Wc"; addRanges = true; break;
         case MaxSensors: name << "X"; break; // Shouldn't happen
         case FoodBeam:   name << "Fb"; break;
         case WormBeam:   name << "Wb"; break;
         case WallBeam:   name << "Eb"; break;
+        case FoodNearest: name << "Fd"; break;
+        case WormNearest: name << "Wd"; break;
+        case FoodGradient: name << "Fg"; break;
         }
         if (addRanges)
         {
@@ -107,6 +158,16 @@ std::string MutantBrain::fullName() const
     return name.str();
 }
 
+/**
+ * @brief Get a hash of the brain including its sensors
+ * @return 64 bit hash of the brain
+ */
+quint64 MutantBrain::contentHash() const
+{
+    quint64 hash = hashBytes(&m_numSensors, sizeof(m_numSensors), IOBrain::contentHash());
+    return hashBytes(m_sensors, m_numSensors * sizeof(Sensor), hash);
+}
+
 
 /**
  * @brief Return a randomly generater sensor
@@ -169,111 +230,184 @@ Brain *MutantBrain::clone(Worm *worm)
     return new MutantBrain(*this, worm);
 }
 
+/**
+ * @brief Add the sensors and the sensor program as well as the IOBrain memory
+ * @param usage where to add the bytes
+ */
+void MutantBrain::memoryUsage(MemoryUsage &usage) const
+{
+    IOBrain::memoryUsage(usage);
+    usage.add(MemoryUsage::Sensors, m_sensorCapacity * sizeof(Sensor));
+    for (auto &program : {m_program, m_spareProgram})
+    {
+        if (!program) continue;
+        size_t programBytes = sizeof(*program) + MemoryUsage::vectorBytes(*program);
+        for (auto &step : *program) programBytes += MemoryUsage::vectorBytes(step.ranges);
+        usage.addShared(MemoryUsage::Sensors, program.get(), programBytes);
+    }
+}
+
+/**
+ * @brief Write the brain
+ *
+ * Each output is written as a list of input index and weight pairs
+ *
+ * @param out stream to write to
+ */
 void MutantBrain::write(QDataStream &out)
 {
     out << m_numSensors;
-    std::map<BrainCell *, int> linkMap;
-    for (uint j = 0; j < 2; j++) m_outputs[j].writeLinks(out, linkMap);
+    for (uint j = 0; j < 2; j++)
+    {
+        out << (int)m_numInputs;
+        for (uint k = 0; k < m_numInputs; k++) out << (int)k << inputWeight(j, k);
+    }
     for (uint j = 0; j < m_numSensors; j++) out << m_sensors[j];
 }
 
+/**
+ * @brief Read the brain
+ *
+ * Inputs without a weight in the stream get a weight of 0
+ *
+ * @param in stream to read from
+ */
 void MutantBrain::read(QDataStream &in)
 {
-    in >> m_numSensors;
-    if (m_numInputs != m_numSensors * 4)
-    {
-        delete [] m_inputs;
-        m_numInputs = m_numSensors * 4;
-        m_inputs = new InputBrainCell[m_numInputs];
-        delete [] m_sensors;
-        m_sensors = new int[m_numSensors];
-    }
-    BrainCell *linkArray[m_numInputs];
-    for (uint j = 0; j < m_numInputs; j++) linkArray[j] = &m_inputs[j];
+    uint numSensors;
+    in >> numSensors;
+    resizeSensors(numSensors);
+    resizeInputs(m_numSensors * 4);
+    ownWeights().assign(m_numInputs * 2, 0);
     for (uint j = 0; j < 2; j++)
     {
-        m_outputs[j].readLinks(in, linkArray);
-        Q_ASSERT(m_outputs[j].checkLinks(m_inputs, m_inputs + m_numInputs - 1));
+        int numLinks;
+        in >> numLinks;
+        for (int k = 0; k < numLinks; k++)
+        {
+            int linkId, weight;
+            in >> linkId >> weight;
+            Q_ASSERT(linkId >= 0 && uint(linkId) < m_numInputs);
+            setInputWeight(j, linkId, weight);
+        }
     }
-    for (uint j = 0; j < m_numSensors; j++) in >> m_sensors[j];    
+    for (uint j = 0; j < m_numSensors; j++) in >> m_sensors[j];
+    setupSensorGroups();
 }
 
 
 /**
- * @brief Fill the inputs with the food seen sensor data
- * @param pt worm head position
- * @param dir directin worm is facing
+ * @brief Set up the sensor groups and the sensor program from the sensors
+ *
+ * All the sensors of one type are filled by a single sensor call
+ * so become one group with 4 inputs per sensor. The program holds
+ * the sensor type and ranges for each group so they don't have to
+ * be unpacked from the sensors every time the group is filled.
+ *
+ * Must be called whenever the sensors change. The program is rebuilt
+ * where it is unless it is shared.
  */
-void MutantBrain::fillInputs(QPoint pt, int dir)
+void MutantBrain::setupSensorGroups()
 {
-    int ranges[m_numSensors];
-    uint numRanges = 0;
+    weightsChanged();
+    m_sensorGroups.clear();
+    if (m_program.use_count() != 1)
+    {
+        if (m_spareProgram) m_program = std::move(m_spareProgram);
+        else m_program = std::allocate_shared<SensorProgram>(PoolAllocator<SensorProgram>());
+    }
+    SensorProgram &program = *m_program;
+    uint numSteps = 0;
     uint j = 0;
-    SensorType lastSensorType = sensorType(m_sensors[0]);
-    ranges[numRanges++] = sensorRange(m_sensors[0]);
-    j++;
+    while (j < m_numSensors)
+    {
+        SensorType type = sensorType(m_sensors[j]);
+        uint numSensors = 1;
+        while (j + numSensors < m_numSensors && sensorType(m_sensors[j + numSensors]) == type) numSensors++;
+        int maxValue = 1;
+        if (type == FoodCount || type == WormCount) maxValue = UnboundedInput;
+        else if (type == FoodNearest || type == WormNearest) maxValue = m_worm->tank()->maxDistance();
+        addSensorGroup(numSensors * 4, maxValue);
+
+        if (numSteps == program.size()) program.push_back(SensorStep());
+        SensorStep &step = program[numSteps++];
+        step.type = type;
+        step.firstInput = j * 4;
+        step.ranges.clear();
+        for (uint k = j; k < j + numSensors; k++) step.ranges.push_back(sensorRange(m_sensors[k]));
+        j += numSensors;
+    }
+    program.resize(numSteps);
+}
 
-    InputBrainCell *inputs = m_inputs;
+/**
+ * @brief Fill the inputs for all the sensors of one type
+ * @param group sensor group to fill
+ * @param pt worm head position
+ * @param dir directin worm is facing
+ */
+void MutantBrain::fillSensorGroup(uint group, QPoint pt, int dir)
+{
+    const SensorStep &step = (*m_program)[group];
+    const int *ranges = step.ranges.data();
+    int numRanges = step.ranges.size();
+    int *inputs = m_inputs + step.firstInput;
+    WormTank *tank = m_worm->tank();
 
-    while (j <= m_numSensors)
+    switch(step.type)
     {
-       SensorType type = (j < m_numSensors) ? sensorType(m_sensors[j]) : MaxSensors;
-       if (type == lastSensorType)
-       {
-           ranges[numRanges++] = sensorRange(m_sensors[j]);
-       } else
-       {
-           switch(lastSensorType)
-           {
-           case FoodNextTo:
-               m_worm->tank()->foodNextTo(pt, dir, inputs);
-               break;
-           case WormNextTo:
-               m_worm->tank()->wormNextTo(pt, dir, inputs);
-               break;
-           case WallNextTo:
-               m_worm->tank()->wallNextTo(pt, dir, inputs);
-               break;
-           case FoodSeen:
-               m_worm->tank()->foodSeen(pt, dir, inputs );
-               break;
-           case WormSeen:
-               m_worm->tank()->wormSeen(pt, dir, inputs );
-               break;
-           case FoodRange:
-               m_worm->tank()->foodSeen(pt, dir, ranges, numRanges, inputs );
-               break;
-           case WormRange:
-               m_worm->tank()->wormSeen(pt, dir, ranges, numRanges, inputs );
-               break;
-           case WallRange:
-               m_worm->tank()->wallSeen(pt, dir, ranges, numRanges, inputs );
-               break;
-           case FoodCount:
-               m_worm->tank()->foodCount(pt, dir, ranges, numRanges, inputs );
-               break;
-           case WormCount:
-               m_worm->tank()->wormCount(pt, dir, ranges, numRanges, inputs );
-               break;
-           case FoodBeam:
-               m_worm->tank()->foodBeam(pt, dir, inputs);
-               break;
-           case WormBeam:
-               m_worm->tank()->wormBeam(pt, dir, inputs);
-               break;
-           case WallBeam:
-               m_worm->tank()->wallBeam(pt, dir, inputs);
-               break;
-           case MaxSensors:
-               // Should never get here
-               Q_ASSERT(false);
-               break;
-           }
-           lastSensorType = type;
-           inputs += 4;
-           numRanges = 0;
-       }
-       j++;
+    case FoodNextTo:
+        tank->foodNextTo(pt, dir, inputs);
+        break;
+    case WormNextTo:
+        tank->wormNextTo(pt, dir, inputs);
+        break;
+    case WallNextTo:
+        tank->wallNextTo(pt, dir, inputs);
+        break;
+    case FoodSeen:
+        tank->foodSeen(pt, dir, inputs );
+        break;
+    case WormSeen:
+        tank->wormSeen(pt, dir, inputs );
+        break;
+    case FoodRange:
+        tank->foodSeen(pt, dir, ranges, numRanges, inputs );
+        break;
+    case WormRange:
+        tank->wormSeen(pt, dir, ranges, numRanges, inputs );
+        break;
+    case WallRange:
+        tank->wallSeen(pt, dir, ranges, numRanges, inputs );
+        break;
+    case FoodCount:
+        tank->foodCount(pt, dir, ranges, numRanges, inputs );
+        break;
+    case WormCount:
+        tank->wormCount(pt, dir, ranges, numRanges, inputs );
+        break;
+    case FoodBeam:
+        tank->foodBeam(pt, dir, inputs);
+        break;
+    case WormBeam:
+        tank->wormBeam(pt, dir, inputs);
+        break;
+    case WallBeam:
+        tank->wallBeam(pt, dir, inputs);
+        break;
+    case FoodNearest:
+        tank->foodNearest(pt, dir, inputs);
+        break;
+    case WormNearest:
+        tank->wormNearest(pt, dir, inputs);
+        break;
+    case FoodGradient:
+        tank->foodGradient(pt, dir, inputs);
+        break;
+    case MaxSensors:
+        // Should never get here
+        Q_ASSERT(false);
+        break;
     }
 }
 
@@ -290,7 +424,9 @@ void MutantBrain::average(Brain *other)
 	Sensor *sensor = m_sensors, *sensorEnd = m_sensors + m_numSensors;
     Sensor *otherSensor = otherBrain->m_sensors, *otherSensorEnd = otherBrain->m_sensors + otherBrain->m_numSensors;
 	
-    std::vector<std::pair<Sensor, Sensor>> averageList;
+    // Reused by every call as brains are only bred on one thread
+    static PoolVector<std::pair<Sensor, Sensor>> averageList;
+    averageList.clear();
 	
 	while (sensor != sensorEnd && otherSensor != otherSensorEnd)
 	{
@@ -357,17 +493,13 @@ void MutantBrain::average(Brain *other)
 	{
         uint myIdx = findSensor(averageFrom.first);
         uint otherIdx = otherBrain->findSensor(averageFrom.second);
+        if (myIdx == m_numSensors || otherIdx == otherBrain->m_numSensors) continue;
 
-		for (int j = 0; j < 2; j++)
-		{
-			for (int k = 0; k < 4; k++)
-			{
-                m_outputs[j].averageWeight(&m_inputs[myIdx * 4 + k],
-                    otherBrain->m_outputs[j].getWeight(&(otherBrain->m_inputs[otherIdx * 4 + k]))
-					);
-			}
-		}
+        // The 4 inputs of a sensor have 8 weights next to each other
+        averageGenes(&ownWeights()[myIdx * 8], &otherBrain->weights()[otherIdx * 8], 8);
 	}
+    // Ranges may have changed
+    setupSensorGroups();
 }
 
 /**
@@ -382,8 +514,11 @@ void MutantBrain::mix(Brain *other)
 
 	// Mix the sensors
     uint minSensors = std::min(m_numSensors, otherBrain->m_numSensors);
-	std::vector<Sensor> removeList;
-	std::vector<Sensor> addList;
+    // Reused by every call as brains are only bred on one thread
+    static PoolVector<Sensor> removeList;
+    static PoolVector<Sensor> addList;
+    removeList.clear();
+    addList.clear();
 	for (uint j = 0; j < minSensors; j++)
 	{
 		if (std::rand() & 1)
@@ -402,16 +537,11 @@ void MutantBrain::mix(Brain *other)
 		addSensor(sensor);
         int otherIdx = otherBrain->findSensor(sensor);
 		int myIdx = findSensor(sensor);
-		for (int j = 0; j < 2; j++)
-		{
-			for (int k = 0; k < 4; k++)
-			{
-                m_outputs[j].setWeight(&m_inputs[myIdx * 4 + k],
-                    otherBrain->m_outputs[j].getWeight(&(otherBrain->m_inputs[otherIdx * 4 + k]))
-					);
-			}
-		}
+        if (uint(myIdx) == m_numSensors || uint(otherIdx) == otherBrain->m_numSensors) continue;
+        const int *otherWeights = &otherBrain->weights()[otherIdx * 8];
+        std::copy(otherWeights, otherWeights + 8, &ownWeights()[myIdx * 8]);
 	}
+    weightsChanged();
 }
 
 /**
@@ -427,10 +557,7 @@ void MutantBrain::randomise(int chance, int weight)
 {
     if (randPercent() <= 10) mutate();
 
-    for (int j = 0; j < 2; j++)
-    {
-        m_outputs[j].randomise(chance, weight);
-    }
+    IOBrain::randomise(chance, weight);
 }
 
 /**
@@ -462,65 +589,26 @@ void MutantBrain::addSensor(Sensor newSensor)
     // Only add new sensors
     if (addIdx < m_numSensors && m_sensors[addIdx] == newSensor) return;
 
-    InputBrainCell *newInputs = new InputBrainCell[m_numInputs + 4];
-    Sensor *newSensors = new Sensor[m_numSensors+1];
+    uint numSensors = m_numSensors;
+    resizeSensors(numSensors + 1);
+    std::copy_backward(m_sensors + addIdx, m_sensors + numSensors, m_sensors + m_numSensors);
+    m_sensors[addIdx] = newSensor;
 
-    uint j;
-    for (j = 0; j < addIdx; j++)
-    {
-        newSensors[j] = m_sensors[j];
-    }
-    for (j = addIdx; j < m_numSensors; j++)
-    {
-        newSensors[j+1] = m_sensors[j];
-    }
-    newSensors[addIdx] = newSensor;
+    // Move the inputs after the new sensor along
+    uint numInputs = m_numInputs;
+    resizeInputs(numInputs + 4);
+    std::copy_backward(m_inputs + addIdx * 4, m_inputs + numInputs, m_inputs + m_numInputs);
+    std::fill(m_inputs + addIdx * 4, m_inputs + addIdx * 4 + 4, 0);
 
-    // Copy inputs
-    for (j = 0; j < addIdx * 4; j++)
-    {
-        newInputs[j] = m_inputs[j];
-    }
-    for (j = addIdx * 4; j < m_numInputs; j++)
-    {
-        newInputs[j+4] = m_inputs[j];
-    }
-
-    // Fix up output links
-    for (j = 0; j < 2; j++)
-    {
-        if (addIdx > 0)
-        {
-            m_outputs[j].renameLinks(newInputs, m_inputs, m_inputs + addIdx * 4 - 1);
-        }
-        if (addIdx < m_numInputs)
-        {
-            m_outputs[j].renameLinks(newInputs + (addIdx+1) * 4,
-                                     m_inputs + addIdx * 4,
-                                     m_inputs + m_numInputs - 1);
-        }
-    }
-
-    // Add new links
-    for (j = 0; j < 2; j++)
-    {
-        for (int k = 0; k < 4; k++)
-        {
-            m_outputs[j].addLink(&newInputs[addIdx * 4 + k], randBetween(-5,5));
-        }
-    }
-
-    delete [] m_inputs;
-    delete [] m_sensors;
-    m_inputs = newInputs;
-    m_sensors = newSensors;
-    m_numInputs += 4;
-    m_numSensors++;
-
-    for (int j = 0; j < 2; j++)
+    // Add weights for the new inputs
+    int newWeights[8];
+    for (uint j = 0; j < 2; j++)
     {
-        Q_ASSERT(m_outputs[j].checkLinks(m_inputs, m_inputs + m_numInputs - 1));
+        for (int k = 0; k < 4; k++) newWeights[k * 2 + j] = randBetween(-5,5);
     }
+    Weights &weights = ownWeights();
+    weights.insert(weights.begin() + addIdx * 8, newWeights, newWeights + 8);
+    setupSensorGroups();
 }
 
 /**
@@ -545,28 +633,17 @@ void MutantBrain::removeSensor(Sensor sensor)
  */
 void MutantBrain::removeSensorAt(uint removeIdx)
 {
-    // Remove links to input cells and rename to move down
-    for (int j = 0; j < 2; j++)
-    {
-        InputBrainCell *removeStart = m_inputs + 4 * removeIdx;
-        InputBrainCell *removeEnd = removeStart + 3;
-        m_outputs[j].removeLinks(removeStart, removeEnd);
-        if (removeIdx < m_numSensors - 1)
-        {
-            m_outputs[j].renameLinks(removeStart, removeEnd+1, m_inputs + m_numInputs - 1);
-        }
-    }
+    // Remove the weights for the sensor inputs
+    Weights &weights = ownWeights();
+    auto removeStart = weights.begin() + 8 * removeIdx;
+    weights.erase(removeStart, removeStart + 8);
 
     m_numSensors--;
     // Shift the input values left to fill the gap created
     m_numInputs-=4;
     for (uint j = removeIdx * 4; j < m_numInputs; j++)
     {
-        m_inputs[j].setValue(m_inputs[j+4].value());
-    }
-
-    for (int j = 0; j < 2; j++)
-    {
-        Q_ASSERT(m_outputs[j].checkLinks(m_inputs, m_inputs + m_numInputs - 1));
+        m_inputs[j] = m_inputs[j+4];
     }
+    setupSensorGroups();
 }
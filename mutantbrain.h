@@ -2,6 +2,7 @@
 #define MUTANTBRAIN_H
 
 #include "iobrain.h"
+#include <memory>
 
 /**
  * @brief Class with an IOBrain that mutates
@@ -15,9 +16,10 @@ public:
 
     virtual const std::string &name() const;
     virtual std::string fullName() const;
+    virtual quint64 contentHash() const;
 
     virtual Brain *clone(Worm *worm);
-
+    virtual bool copyFrom(const Brain &other);
 
 
     typedef int Sensor;
@@ -36,17 +38,21 @@ public:
         FoodBeam,
         WormBeam,
         WallBeam,
+        FoodNearest,
+        WormNearest,
+        FoodGradient,
         MaxSensors
     };
 
 protected:
-    virtual void fillInputs(QPoint pt, int dir);
+    virtual void fillSensorGroup(uint group, QPoint pt, int dir);
 
     virtual void average(Brain *other);
     virtual void mix(Brain *other);
     virtual void randomise(int chance, int weight);
     virtual void write(QDataStream &out);
     virtual void read(QDataStream &in);
+    virtual void memoryUsage(MemoryUsage &usage) const;
 
 
     void mutate();
@@ -62,10 +68,26 @@ protected:
     void addSensor(Sensor sensor);
     void removeSensor(Sensor sensor);
     void removeSensorAt(uint removeIdx);
+    void resizeSensors(uint numSensors);
+    void setupSensorGroups();
+
+    /**
+     * @brief One sensor call in the compiled sensor program
+     */
+    struct SensorStep
+    {
+        SensorType type;
+        uint firstInput;
+        PoolVector<int> ranges;
+    };
+    typedef PoolVector<SensorStep> SensorProgram;
 
 protected:
     uint m_numSensors;
+    uint m_sensorCapacity;
     Sensor *m_sensors;
+    std::shared_ptr<SensorProgram> m_program; // One step for each sensor group, shared with clones and never changed while shared
+    std::shared_ptr<SensorProgram> m_spareProgram; // Program kept from before the brain was copied into
     const uint MaxNumberOfSensors = 20;
 };
 
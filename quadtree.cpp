@@ -0,0 +1,389 @@
+#include "quadtree.h"
+#include "direction.h"
+#include <algorithm>
+
+QuadTree::QuadTree() :
+    m_width(0),
+    m_height(0),
+    m_size(0)
+{
+    clear();
+}
+
+/**
+ * @brief Set the area covered by the tree
+ *
+ * Removes all the points from the tree
+ *
+ * @param width width of the tank
+ * @param height height of the tank
+ */
+void QuadTree::setSize(int width, int height)
+{
+    m_width = width;
+    m_height = height;
+    clear();
+}
+
+/**
+ * @brief Get the number of bytes allocated for the nodes and their points
+ */
+size_t QuadTree::memoryBytes() const
+{
+    size_t bytes = m_nodes.capacity() * sizeof(Node) + m_freeNodes.capacity() * sizeof(int);
+    for (auto &node : m_nodes) bytes += node.points.capacity() * sizeof(QPoint);
+    return bytes;
+}
+
+/**
+ * @brief Remove all the points from the tree
+ */
+void QuadTree::clear()
+{
+    m_nodes.clear();
+    m_freeNodes.clear();
+    Node root;
+    root.x0 = root.y0 = 0;
+    root.x1 = m_width;
+    root.y1 = m_height;
+    root.children = -1;
+    m_nodes.push_back(root);
+    m_size = 0;
+}
+
+/**
+ * @brief Add a point to the tree
+ * @param pt point to add
+ */
+void QuadTree::insert(QPoint pt)
+{
+    int nodeIdx = 0;
+    while (m_nodes[nodeIdx].children >= 0) nodeIdx = childFor(m_nodes[nodeIdx], pt);
+
+    m_nodes[nodeIdx].points.push_back(pt);
+    m_size++;
+    if (m_nodes[nodeIdx].points.size() > LeafCapacity) split(nodeIdx);
+}
+
+/**
+ * @brief Remove a point from the tree
+ *
+ * Leaves that become nearly empty are merged back into their parent
+ *
+ * @param pt point to remove
+ * @return true if the point was in the tree
+ */
+bool QuadTree::remove(QPoint pt)
+{
+    int path[64];
+    int depth = 0;
+    int nodeIdx = 0;
+    while (m_nodes[nodeIdx].children >= 0)
+    {
+        path[depth++] = nodeIdx;
+        nodeIdx = childFor(m_nodes[nodeIdx], pt);
+    }
+
+    std::vector<QPoint> &points = m_nodes[nodeIdx].points;
+    auto found = std::find(points.begin(), points.end(), pt);
+    if (found == points.end()) return false;
+    *found = points.back();
+    points.pop_back();
+    m_size--;
+
+    // Merge parents that now hold few enough points to be a leaf
+    while (depth > 0)
+    {
+        Node &parent = m_nodes[path[--depth]];
+        uint total = 0;
+        for (int c = 0; c < 4; c++)
+        {
+            const Node &child = m_nodes[parent.children + c];
+            if (child.children >= 0) return true;
+            total += child.points.size();
+        }
+        if (total > LeafCapacity / 2) break;
+        merge(path[depth]);
+    }
+
+    return true;
+}
+
+/**
+ * @brief Find the nearest point to the given point
+ *
+ * The point itself is never returned.
+ *
+ * @param pt point to search from
+ * @param dir only find points in this direction cone or AnyDirection
+ * @param found set to the nearest point
+ * @param distSquared set to the square of the distance to the nearest point
+ * @return true if a point was found
+ */
+bool QuadTree::nearest(QPoint pt, int dir, QPoint &found, int &distSquared) const
+{
+    std::vector<std::pair<int, QPoint> > best;
+    search(0, pt, dir, 1, best);
+    if (best.empty()) return false;
+    distSquared = best[0].first;
+    found = best[0].second;
+    return true;
+}
+
+/**
+ * @brief Find the k nearest points to a given point
+ *
+ * The point itself is never returned.
+ *
+ * @param pt point to search from
+ * @param dir only find points in this direction cone or AnyDirection
+ * @param k maximum number of points to find
+ * @param found set to the points found, nearest first
+ */
+void QuadTree::nearest(QPoint pt, int dir, uint k, std::vector<QPoint> &found) const
+{
+    std::vector<std::pair<int, QPoint> > best;
+    found.clear();
+    if (k == 0) return;
+    search(0, pt, dir, k, best);
+    for (auto item : best) found.push_back(item.second);
+}
+
+/**
+ * @brief Check if there are any points in a direction cone
+ *
+ * Points in the same row or column as the given point are ignored, as
+ * they always have been by the seen sensors.
+ *
+ * @param pt point to look from
+ * @param dir direction cone to look in
+ * @return true if a point was found
+ */
+bool QuadTree::anyInCone(QPoint pt, int dir) const
+{
+    return searchCone(0, pt, dir);
+}
+
+/**
+ * @brief Find all the points within a distance of a point
+ *
+ * The point itself is included if it is in the tree.
+ *
+ * @param pt point to search from
+ * @param distSquared square of the largest distance to include
+ * @param found set to the points found, in no particular order
+ */
+void QuadTree::within(QPoint pt, int distSquared, std::vector<QPoint> &found) const
+{
+    found.clear();
+    if (distSquared >= 0) searchWithin(0, pt, distSquared, found);
+}
+
+/**
+ * @brief Split a leaf into four children
+ * @param nodeIdx index of the leaf
+ */
+void QuadTree::split(int nodeIdx)
+{
+    if (m_nodes[nodeIdx].x1 - m_nodes[nodeIdx].x0 <= 1 && m_nodes[nodeIdx].y1 - m_nodes[nodeIdx].y0 <= 1) return;
+
+    int first;
+    if (m_freeNodes.empty())
+    {
+        first = m_nodes.size();
+        m_nodes.resize(first + 4);
+    } else
+    {
+        first = m_freeNodes.back();
+        m_freeNodes.pop_back();
+    }
+
+    Node &node = m_nodes[nodeIdx];
+    int midX = (node.x0 + node.x1) / 2;
+    int midY = (node.y0 + node.y1) / 2;
+    for (int c = 0; c < 4; c++)
+    {
+        Node &child = m_nodes[first + c];
+        child.x0 = (c & 1) ? midX : node.x0;
+        child.x1 = (c & 1) ? node.x1 : midX;
+        child.y0 = (c & 2) ? midY : node.y0;
+        child.y1 = (c & 2) ? node.y1 : midY;
+        child.children = -1;
+        child.points.clear();
+    }
+    node.children = first;
+
+    std::vector<QPoint> points;
+    points.swap(node.points);
+    for (auto pt : points)
+    {
+        m_nodes[childFor(m_nodes[nodeIdx], pt)].points.push_back(pt);
+    }
+    for (int c = 0; c < 4; c++)
+    {
+        if (m_nodes[first + c].points.size() > LeafCapacity) split(first + c);
+    }
+}
+
+/**
+ * @brief Merge the four leaf children of a node back into it
+ * @param nodeIdx index of the node
+ */
+void QuadTree::merge(int nodeIdx)
+{
+    int first = m_nodes[nodeIdx].children;
+    for (int c = 0; c < 4; c++)
+    {
+        std::vector<QPoint> &points = m_nodes[first + c].points;
+        m_nodes[nodeIdx].points.insert(m_nodes[nodeIdx].points.end(), points.begin(), points.end());
+        points.clear();
+    }
+    m_nodes[nodeIdx].children = -1;
+    m_freeNodes.push_back(first);
+}
+
+/**
+ * @brief Get the child of a node that contains a point
+ */
+int QuadTree::childFor(const Node &node, QPoint pt) const
+{
+    int midX = (node.x0 + node.x1) / 2;
+    int midY = (node.y0 + node.y1) / 2;
+    return node.children + (pt.x() >= midX ? 1 : 0) + (pt.y() >= midY ? 2 : 0);
+}
+
+/**
+ * @brief Get the square of the smallest distance from a point to a node
+ */
+int QuadTree::minDistSquared(const Node &node, QPoint pt) const
+{
+    int dx = std::max(std::max(node.x0 - pt.x(), pt.x() - (node.x1 - 1)), 0);
+    int dy = std::max(std::max(node.y0 - pt.y(), pt.y() - (node.y1 - 1)), 0);
+    return dx * dx + dy * dy;
+}
+
+/**
+ * @brief Check if any of a node could be in a direction cone
+ *
+ * The cone is the 90 degree wedge centred on the direction, the test
+ * includes the edges of the wedge so it may include a node that only
+ * touches it.
+ */
+bool QuadTree::nodeInCone(const Node &node, QPoint pt, int dir) const
+{
+    if (dir == AnyDirection) return true;
+
+    int minX = node.x0 - pt.x(), maxX = node.x1 - 1 - pt.x();
+    int minY = node.y0 - pt.y(), maxY = node.y1 - 1 - pt.y();
+    int forward, sideMin, sideMax;
+    switch (dir)
+    {
+    case 0:  forward = maxY;  sideMin = minX; sideMax = maxX; break;
+    case 1:  forward = maxX;  sideMin = minY; sideMax = maxY; break;
+    case 2:  forward = -minY; sideMin = minX; sideMax = maxX; break;
+    default: forward = -minX; sideMin = minY; sideMax = maxY; break;
+    }
+    int side = (sideMin > 0) ? sideMin : (sideMax < 0) ? -sideMax : 0;
+    return forward >= side;
+}
+
+/**
+ * @brief Check if a point is in the direction cone from another point
+ */
+bool QuadTree::pointInCone(QPoint pt, QPoint from, int dir) const
+{
+    int xDiff = pt.x() - from.x();
+    int yDiff = pt.y() - from.y();
+    if (xDiff == 0 && yDiff == 0) return false;
+    return (dir == AnyDirection || direction(xDiff, yDiff) == dir);
+}
+
+/**
+ * @brief Recursively search for the k nearest points
+ * @param nodeIdx node to search
+ * @param pt point to search from
+ * @param dir direction cone or AnyDirection
+ * @param k number of points to find
+ * @param best nearest points found so far, sorted by distance
+ */
+void QuadTree::search(int nodeIdx, QPoint pt, int dir, uint k, std::vector<std::pair<int, QPoint> > &best) const
+{
+    const Node &node = m_nodes[nodeIdx];
+    if (best.size() == k && minDistSquared(node, pt) >= best.back().first) return;
+    if (!nodeInCone(node, pt, dir)) return;
+
+    if (node.children < 0)
+    {
+        for (auto nodePt : node.points)
+        {
+            if (!pointInCone(nodePt, pt, dir)) continue;
+            int xDiff = nodePt.x() - pt.x();
+            int yDiff = nodePt.y() - pt.y();
+            int distSquared = xDiff * xDiff + yDiff * yDiff;
+            if (best.size() == k && distSquared >= best.back().first) continue;
+            auto insertPos = std::upper_bound(best.begin(), best.end(), distSquared,
+                                              [](int dist, const std::pair<int, QPoint> &item) {return dist < item.first;});
+            best.insert(insertPos, std::make_pair(distSquared, nodePt));
+            if (best.size() > k) best.pop_back();
+        }
+        return;
+    }
+
+    // Visit the nearest children first so more can be pruned
+    int order[4], dist[4];
+    for (int c = 0; c < 4; c++)
+    {
+        order[c] = c;
+        dist[c] = minDistSquared(m_nodes[node.children + c], pt);
+    }
+    std::sort(order, order + 4, [&dist](int a, int b) {return dist[a] < dist[b];});
+    int first = node.children;
+    for (int c = 0; c < 4; c++) search(first + order[c], pt, dir, k, best);
+}
+
+/**
+ * @brief Recursively search for an off axis point in a direction cone
+ * @return true if one was found
+ */
+bool QuadTree::searchCone(int nodeIdx, QPoint pt, int dir) const
+{
+    const Node &node = m_nodes[nodeIdx];
+    if (!nodeInCone(node, pt, dir)) return false;
+
+    if (node.children < 0)
+    {
+        for (auto nodePt : node.points)
+        {
+            if (nodePt.x() != pt.x() && nodePt.y() != pt.y() && pointInCone(nodePt, pt, dir)) return true;
+        }
+        return false;
+    }
+
+    for (int c = 0; c < 4; c++)
+    {
+        if (searchCone(node.children + c, pt, dir)) return true;
+    }
+    return false;
+}
+
+/**
+ * @brief Recursively collect the points within a distance
+ */
+void QuadTree::searchWithin(int nodeIdx, QPoint pt, int distSquared, std::vector<QPoint> &found) const
+{
+    const Node &node = m_nodes[nodeIdx];
+    if (minDistSquared(node, pt) > distSquared) return;
+
+    if (node.children < 0)
+    {
+        for (auto nodePt : node.points)
+        {
+            int xDiff = nodePt.x() - pt.x();
+            int yDiff = nodePt.y() - pt.y();
+            if (xDiff * xDiff + yDiff * yDiff <= distSquared) found.push_back(nodePt);
+        }
+        return;
+    }
+
+    for (int c = 0; c < 4; c++) searchWithin(node.children + c, pt, distSquared, found);
+}
@@ -0,0 +1,68 @@
+#ifndef QUADTREE_H
+#define QUADTREE_H
+
+#include <QPoint>
+#include <vector>
+
+/**
+ * @brief Dynamic quadtree of points in the tank
+ *
+ * Points are added and removed as the tank changes so the tree never
+ * has to be rebuilt. It answers nearest and k-nearest queries that can
+ * be restricted to one of the four direction cones used by the sensors.
+ */
+class QuadTree
+{
+public:
+    QuadTree();
+
+    void setSize(int width, int height);
+    void clear();
+
+    void insert(QPoint pt);
+    bool remove(QPoint pt);
+
+    uint size() const {return m_size;}
+    size_t memoryBytes() const;
+
+    /**
+     * @brief Direction to use for queries that look all around
+     */
+    static const int AnyDirection = -1;
+
+    bool nearest(QPoint pt, int dir, QPoint &found, int &distSquared) const;
+    void nearest(QPoint pt, int dir, uint k, std::vector<QPoint> &found) const;
+    bool anyInCone(QPoint pt, int dir) const;
+    void within(QPoint pt, int distSquared, std::vector<QPoint> &found) const;
+
+private:
+    /**
+     * @brief Node of the tree covering the cells x0 <= x < x1, y0 <= y < y1
+     */
+    struct Node
+    {
+        int x0, y0, x1, y1;
+        int children; // Index of first of 4 children or -1 for a leaf
+        std::vector<QPoint> points;
+    };
+
+    void split(int nodeIdx);
+    void merge(int nodeIdx);
+    int childFor(const Node &node, QPoint pt) const;
+    int minDistSquared(const Node &node, QPoint pt) const;
+    bool nodeInCone(const Node &node, QPoint pt, int dir) const;
+    bool pointInCone(QPoint pt, QPoint from, int dir) const;
+    void search(int nodeIdx, QPoint pt, int dir, uint k, std::vector<std::pair<int, QPoint> > &best) const;
+    bool searchCone(int nodeIdx, QPoint pt, int dir) const;
+    void searchWithin(int nodeIdx, QPoint pt, int distSquared, std::vector<QPoint> &found) const;
+
+private:
+    static const uint LeafCapacity = 8;
+    int m_width;
+    int m_height;
+    uint m_size;
+    std::vector<Node> m_nodes;
+    std::vector<int> m_freeNodes;
+};
+
+#endif // QUADTREE_H
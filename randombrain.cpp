@@ -1,5 +1,6 @@
 #include "randombrain.h"
-#include <cstdlib>
+#include "worm.h"
+#include "wormtank.h"
 
 // Register the Random Brain type
 BrainCreator<RandomBrain> g_randomBrainCreator(
@@ -7,7 +8,9 @@ BrainCreator<RandomBrain> g_randomBrainCreator(
      "A completely random direction is chosen for every move"
      );
 
-RandomBrain::RandomBrain(Worm *worm) : Brain(worm)
+RandomBrain::RandomBrain(Worm *worm) :
+    Brain(worm),
+    m_randomState(worm->tank()->nextRandomSeed())
 {
 }
 
@@ -36,7 +39,12 @@ void RandomBrain::read(QDataStream &in)
  */
 void RandomBrain::planMove(QPoint &pt, int &dir)
 {
-    dir = (dir + (std::rand() & 3) + 3) % 4;
+    // xorshift64*
+    m_randomState ^= m_randomState >> 12;
+    m_randomState ^= m_randomState << 25;
+    m_randomState ^= m_randomState >> 27;
+    int turn = int((m_randomState * 0x2545F4914F6CDD1DULL) >> 62);
+    dir = (dir + turn + 3) % 4;
     switch (dir)
     {
     case 0: pt.ry()--; break;
@@ -55,6 +63,16 @@ Brain *RandomBrain::clone(Worm *worm)
     return new RandomBrain(worm);
 }
 
+/**
+* @brief Start a new sequence of moves as a clone would
+*/
+bool RandomBrain::copyFrom(const Brain &other)
+{
+    if (other.name() != name()) return false;
+    m_randomState = m_worm->tank()->nextRandomSeed();
+    return true;
+}
+
 void RandomBrain::average(Brain *other)
 {
     Q_UNUSED(other)
@@ -16,12 +16,17 @@ public:
 
     virtual const std::string &name() const;
 	virtual void planMove(QPoint &pt, int &dir);
+    virtual bool changesWhenMoving() const {return true;} // Draws each turn from its generator
 
     virtual Brain *clone(Worm *worm);
+    virtual bool copyFrom(const Brain &other);
 
     virtual void average(Brain *other);
     virtual void mix(Brain *other);
 	virtual void randomise(int chance, int weight);	
+
+private:
+    quint64 m_randomState; // Own generator so moves can be planned on any thread
 };
 
 #endif // RANDOMBRAIN_H
@@ -9,6 +9,18 @@ BrainCreator<SimpleWithNextToBrain> g_simpleWithNextToBrainCreator(
         " and if it is next to food/worms or a wall."
         );
 
+/**
+ * @brief Construct a new brain with random weights
+ * @param worm worm to attach the brain to
+ */
+SimpleWithNextToBrain::SimpleWithNextToBrain(Worm *worm) : IOBrain(worm, 16)
+{
+    addSensorGroup(4, 1);
+    addSensorGroup(4, 1);
+    addSensorGroup(4, 1);
+    addSensorGroup(4, 1);
+}
+
 /**
  * @brief Return the name of this brain type
  * @return name of brain type
@@ -29,16 +41,26 @@ Brain *SimpleWithNextToBrain::clone(Worm *worm)
 }
 
 /**
- * @brief Fill the inputs with the food seen and all next to sensor data
+ * @brief Fill the inputs for one of the sensors
+ * @param group sensor group to fill
  * @param pt worm head position
  * @param dir directin worm is facing
  */
-void SimpleWithNextToBrain::fillInputs(QPoint pt, int dir)
+void SimpleWithNextToBrain::fillSensorGroup(uint group, QPoint pt, int dir)
 {
-    m_worm->tank()->foodSeen(pt, dir, m_inputs);
-    m_worm->tank()->foodNextTo(pt, dir, m_inputs+4);
-    m_worm->tank()->wormNextTo(pt, dir, m_inputs+8);
-    m_worm->tank()->wallNextTo(pt, dir, m_inputs+12);
+    switch (group)
+    {
+    case 0:
+        m_worm->tank()->foodSeen(pt, dir, m_inputs);
+        break;
+    case 1:
+        m_worm->tank()->foodNextTo(pt, dir, m_inputs+4);
+        break;
+    case 2:
+        m_worm->tank()->wormNextTo(pt, dir, m_inputs+8);
+        break;
+    case 3:
+        m_worm->tank()->wallNextTo(pt, dir, m_inputs+12);
+        break;
+    }
 }
-
-
@@ -9,7 +9,7 @@
 class SimpleWithNextToBrain : public IOBrain
 {
 public:
-    SimpleWithNextToBrain(Worm *worm) : IOBrain(worm,16) {}
+    SimpleWithNextToBrain(Worm *worm);
     SimpleWithNextToBrain(const SimpleWithNextToBrain &other, Worm *worm) : IOBrain(other, worm) {}
     virtual ~SimpleWithNextToBrain(){}
 
@@ -17,7 +17,7 @@ public:
     virtual Brain *clone(Worm *worm);
 
 protected:
-    virtual void fillInputs(QPoint pt, int dir);
+    virtual void fillSensorGroup(uint group, QPoint pt, int dir);
 };
 
 #endif // SIMPLEWITHNEXTTOBRAIN_H
@@ -10,6 +10,16 @@ BrainCreator<SimpleWithNextToFoodBrain> g_simpleWithNextToFoodBrainCreator(
         " and if it is next to food."
         );
 
+/**
+ * @brief Construct a new brain with random weights
+ * @param worm worm to attach the brain to
+ */
+SimpleWithNextToFoodBrain::SimpleWithNextToFoodBrain(Worm *worm) : IOBrain(worm, 8)
+{
+    addSensorGroup(4, 1);
+    addSensorGroup(4, 1);
+}
+
 /**
  * @brief Return the name of this brain type
  * @return name of brain type
@@ -30,14 +40,20 @@ Brain *SimpleWithNextToFoodBrain::clone(Worm *worm)
 }
 
 /**
- * @brief Fill the inputs with the food seen sensor data
+ * @brief Fill the inputs for one of the sensors
+ * @param group sensor group to fill
  * @param pt worm head position
  * @param dir directin worm is facing
  */
-void SimpleWithNextToFoodBrain::fillInputs(QPoint pt, int dir)
+void SimpleWithNextToFoodBrain::fillSensorGroup(uint group, QPoint pt, int dir)
 {
-    m_worm->tank()->foodSeen(pt, dir, m_inputs);
-    m_worm->tank()->foodNextTo(pt, dir, m_inputs+4);
+    switch (group)
+    {
+    case 0:
+        m_worm->tank()->foodSeen(pt, dir, m_inputs);
+        break;
+    case 1:
+        m_worm->tank()->foodNextTo(pt, dir, m_inputs+4);
+        break;
+    }
 }
-
-
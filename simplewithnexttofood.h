@@ -9,7 +9,7 @@
 class SimpleWithNextToFoodBrain : public IOBrain
 {
 public:
-    SimpleWithNextToFoodBrain(Worm *worm) : IOBrain(worm,8) {}
+    SimpleWithNextToFoodBrain(Worm *worm);
     SimpleWithNextToFoodBrain(const SimpleWithNextToFoodBrain &other, Worm *worm) : IOBrain(other, worm) {}
     virtual ~SimpleWithNextToFoodBrain(){}
 
@@ -17,7 +17,7 @@ public:
     virtual Brain *clone(Worm *worm);
 
 protected:
-    virtual void fillInputs(QPoint pt, int dir);
+    virtual void fillSensorGroup(uint group, QPoint pt, int dir);
 };
 
 #endif // SIMPLEWITHNEXTTOFOOD_H
@@ -0,0 +1,210 @@
+#include "tankgrid.h"
+#include <algorithm>
+#include <cstring>
+
+const int TankGrid::ChunkBits;
+const int TankGrid::ChunkSize;
+const int TankGrid::ChunkMask;
+const uint TankGrid::MaxSpareChunks;
+
+TankGrid::TankGrid() :
+    m_width(0),
+    m_height(0),
+    m_empty(0),
+    m_rowBits(0),
+    m_xMask(0),
+    m_columns(0),
+    m_chunksUsed(0)
+{
+}
+
+TankGrid::~TankGrid()
+{
+    clear();
+    for (auto chunk : m_spareChunks) delete chunk;
+}
+
+/**
+ * @brief Set the size of the tank, emptying all the cells
+ * @param width width of the tank
+ * @param height height of the tank
+ * @param empty value of a cell that has nothing in it
+ */
+void TankGrid::setSize(int width, int height, int empty)
+{
+    clear();
+    m_width = width;
+    m_height = height;
+    m_empty = empty;
+    m_rowBits = 0;
+    while ((1 << m_rowBits) < m_width) m_rowBits++;
+    m_xMask = (1 << m_rowBits) - 1;
+    m_columns = (m_width + ChunkMask) >> ChunkBits;
+    m_chunks.assign(m_columns * ((m_height + ChunkMask) >> ChunkBits), nullptr);
+}
+
+/**
+ * @brief Set all the cells to empty
+ */
+void TankGrid::clear()
+{
+    for (auto &chunk : m_chunks)
+    {
+        if (chunk) releaseChunk(chunk);
+        chunk = nullptr;
+    }
+}
+
+/**
+ * @brief Set the value of a cell
+ *
+ * Allocates the cell's chunk if needed, and frees it if it is left empty.
+ *
+ * @param idx index of the cell
+ * @param value new value for the cell
+ */
+void TankGrid::set(int idx, int value)
+{
+    Chunk *&chunk = m_chunks[chunkFor(idx)];
+    if (chunk == nullptr)
+    {
+        if (value == m_empty) return;
+        chunk = newChunk();
+    }
+
+    uchar &cell = chunk->cells[cellInChunk(idx)];
+    if (cell == m_empty) chunk->used++;
+    if (value == m_empty) chunk->used--;
+    cell = uchar(value);
+
+    if (chunk->used == 0)
+    {
+        releaseChunk(chunk);
+        chunk = nullptr;
+    }
+}
+
+/**
+ * @brief Find the first cell that isn't empty in a line from a cell
+ *
+ * Chunks that aren't allocated are passed over without looking at
+ * their cells.
+ *
+ * @param pt cell to start from, not included in the line
+ * @param dir direction of the line (0 north, 1 east, 2 south, 3 west)
+ * @param count number of cells in the line, all must be in the tank
+ * @return value of the first cell that isn't empty, or the empty value
+ */
+int TankGrid::firstInLine(QPoint pt, int dir, int count) const
+{
+    static const int dx[4] = {0, 1, 0, -1};
+    static const int dy[4] = {1, 0, -1, 0};
+    int x = pt.x();
+    int y = pt.y();
+    int step = dx[dir] + dy[dir] * ChunkSize;
+    while (count > 0)
+    {
+        x += dx[dir];
+        y += dy[dir];
+
+        // Cells from here to the edge of the chunk in the direction of the line
+        int inChunk = 0;
+        switch (dir)
+        {
+        case 0: inChunk = ChunkSize - (y & ChunkMask); break;
+        case 1: inChunk = ChunkSize - (x & ChunkMask); break;
+        case 2: inChunk = (y & ChunkMask) + 1; break;
+        case 3: inChunk = (x & ChunkMask) + 1; break;
+        }
+        inChunk = std::min(inChunk, count);
+
+        const Chunk *chunk = m_chunks[(y >> ChunkBits) * m_columns + (x >> ChunkBits)];
+        if (chunk)
+        {
+            const uchar *cell = chunk->cells + (((y & ChunkMask) << ChunkBits) | (x & ChunkMask));
+            for (int j = 0; j < inChunk; j++, cell += step)
+            {
+                if (*cell != m_empty) return *cell;
+            }
+        }
+
+        count -= inChunk;
+        x += dx[dir] * (inChunk - 1);
+        y += dy[dir] * (inChunk - 1);
+    }
+    return m_empty;
+}
+
+/**
+ * @brief Draw the cells into an image
+ *
+ * Each pixel shows the cell at its position scaled to the tank, so a
+ * small image of a huge tank doesn't need the whole tank drawn first.
+ *
+ * @param size size of the image, or an invalid size for one pixel per cell
+ * @param colours colour for each cell value
+ * @param numColours number of colours
+ * @return image with indexed colours
+ */
+QImage TankGrid::image(QSize size, const QRgb *colours, int numColours) const
+{
+    if (!size.isValid() || size.isEmpty()) size = QSize(m_width, m_height);
+    QImage result(size, QImage::Format_Indexed8);
+    for (int j = 0; j < numColours; j++)
+    {
+        result.setColor(j, colours[j]);
+    }
+    for (int row = 0; row < size.height(); row++)
+    {
+        uchar *pixel = result.scanLine(row);
+        int y = int(qint64(row) * m_height / size.height());
+        for (int col = 0; col < size.width(); col++)
+        {
+            int x = int(qint64(col) * m_width / size.width());
+            pixel[col] = uchar(at(index(QPoint(x, y))));
+        }
+    }
+    return result;
+}
+
+/**
+ * @brief Get the bytes used by the chunks, including the spare ones
+ */
+size_t TankGrid::memoryBytes() const
+{
+    return m_chunks.capacity() * sizeof(Chunk *) + m_spareChunks.capacity() * sizeof(Chunk *)
+            + (m_chunksUsed + m_spareChunks.size()) * sizeof(Chunk);
+}
+
+/**
+ * @brief Get an empty chunk, reusing a spare one if there is one
+ */
+TankGrid::Chunk *TankGrid::newChunk()
+{
+    Chunk *chunk;
+    if (m_spareChunks.empty())
+    {
+        chunk = new Chunk;
+    } else
+    {
+        chunk = m_spareChunks.back();
+        m_spareChunks.pop_back();
+    }
+    std::memset(chunk->cells, m_empty, sizeof(chunk->cells));
+    chunk->used = 0;
+    m_chunksUsed++;
+    return chunk;
+}
+
+/**
+ * @brief Free a chunk that is no longer in the grid
+ *
+ * A few are kept so a worm going back and forth over the edge of a
+ * chunk doesn't allocate it every move.
+ */
+void TankGrid::releaseChunk(Chunk *chunk)
+{
+    m_chunksUsed--;
+    if (m_spareChunks.size() < MaxSpareChunks) m_spareChunks.push_back(chunk);
+    else delete chunk;
+}
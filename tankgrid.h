@@ -0,0 +1,124 @@
+#ifndef TANKGRID_H
+#define TANKGRID_H
+
+#include <QPoint>
+#include <QImage>
+#include <vector>
+
+/**
+ * @brief Colour of every cell in the tank, stored in chunks
+ *
+ * The tank is split into ChunkSize x ChunkSize chunks, and a chunk is
+ * only allocated when one of its cells is set to something other than
+ * the empty value. It is freed again when all its cells are empty, so
+ * a huge tank that is mostly ground only pays for the parts in use.
+ * Each chunk keeps a count of its cells in use so it knows when it is
+ * empty, and lines of cells can skip chunks that aren't allocated.
+ *
+ * Cells are found by an index as if the tank were one array with rows
+ * of rowOffset() cells, so moving one cell in a direction is adding a
+ * fixed offset to the index. An index must only be read for a cell in
+ * the tank.
+ */
+class TankGrid
+{
+public:
+    TankGrid();
+    ~TankGrid();
+
+    void setSize(int width, int height, int empty);
+    void clear();
+
+    /**
+     * @brief Change in the index for moving down one row
+     */
+    int rowOffset() const {return 1 << m_rowBits;}
+
+    /**
+     * @brief Get the index of a cell
+     */
+    inline int index(QPoint pt) const {return (pt.y() << m_rowBits) + pt.x();}
+
+    /**
+     * @brief Get the value of a cell from its index
+     */
+    inline int at(int idx) const
+    {
+        const Chunk *chunk = m_chunks[chunkFor(idx)];
+        return chunk ? chunk->cells[cellInChunk(idx)] : m_empty;
+    }
+
+    void set(int idx, int value);
+
+    /**
+     * @brief Call a function for every cell that isn't empty
+     *
+     * Only the allocated chunks are looked at.
+     *
+     * @param func called with the position and value of each cell
+     */
+    template<class Func> void forEachCell(Func func) const
+    {
+        for (uint chunkIdx = 0; chunkIdx < m_chunks.size(); chunkIdx++)
+        {
+            const Chunk *chunk = m_chunks[chunkIdx];
+            if (chunk == nullptr) continue;
+            int left = (chunkIdx % m_columns) << ChunkBits;
+            int top = (chunkIdx / m_columns) << ChunkBits;
+            for (int cellIdx = 0; cellIdx < ChunkSize * ChunkSize; cellIdx++)
+            {
+                if (chunk->cells[cellIdx] != m_empty)
+                {
+                    func(QPoint(left + (cellIdx & ChunkMask), top + (cellIdx >> ChunkBits)), chunk->cells[cellIdx]);
+                }
+            }
+        }
+    }
+
+    int firstInLine(QPoint pt, int dir, int count) const;
+    QImage image(QSize size, const QRgb *colours, int numColours) const;
+
+    uint chunksUsed() const {return m_chunksUsed;}
+    size_t memoryBytes() const;
+
+    static const int ChunkBits = 6;
+    static const int ChunkSize = 1 << ChunkBits;
+
+private:
+    static const int ChunkMask = ChunkSize - 1;
+    static const uint MaxSpareChunks = 64;
+
+    struct Chunk
+    {
+        uchar cells[ChunkSize * ChunkSize];
+        uint used; // Cells that are not empty
+    };
+
+    inline int chunkFor(int idx) const
+    {
+        return ((idx >> m_rowBits) >> ChunkBits) * m_columns + ((idx & m_xMask) >> ChunkBits);
+    }
+    inline int cellInChunk(int idx) const
+    {
+        return (((idx >> m_rowBits) & ChunkMask) << ChunkBits) | (idx & m_xMask & ChunkMask);
+    }
+
+    Chunk *newChunk();
+    void releaseChunk(Chunk *chunk);
+
+    TankGrid(const TankGrid &other);
+    TankGrid &operator=(const TankGrid &other);
+
+private:
+    int m_width;
+    int m_height;
+    int m_empty;
+    int m_rowBits;
+    int m_xMask;
+    int m_columns; // Chunks across the tank
+    std::vector<Chunk *> m_chunks; // Row by row, nullptr for a chunk that is all empty
+    std::vector<Chunk *> m_spareChunks; // Freed chunks kept to save allocating them again straight away
+    uint m_chunksUsed;
+};
+
+#endif // TANKGRID_H
@@ -0,0 +1,30 @@
+#include "tanksettings.h"
+#include <algorithm>
+
+const int TankSettings::MinSize;
+const int TankSettings::MaxSize;
+const uint TankSettings::MaxWorms;
+const int TankSettings::MinTileSize;
+const uint TankSettings::MinStagnantTicks;
+
+/**
+ * @brief Bring the settings into the range the tank can run
+ *
+ * The worms and food are kept to a quarter of the cells away from the
+ * edges so there is always room to place them, and there must be at
+ * least one child for each survivor. Tiles are no bigger than the tank.
+ * Too few stagnant ticks would waste time looking for loops between meals.
+ */
+void TankSettings::limit()
+{
+    width = std::max(MinSize, std::min(MaxSize, width));
+    height = std::max(MinSize, std::min(MaxSize, height));
+    uint room = uint((width - 20) * (height - 20)) / 4;
+    startWorms = std::max(2u, std::min(std::min(MaxWorms, room / 2), startWorms));
+    startFood = std::min(room - startWorms, startFood);
+    survivors = std::max(1u, std::min(startWorms / 2, survivors));
+    foodEnergy = std::max(1u, foodEnergy);
+    if (tileSize > 0) tileSize = std::max(MinTileSize, std::min(std::max(width, height), tileSize));
+    else tileSize = 0;
+    if (stagnantTicks > 0) stagnantTicks = std::max(MinStagnantTicks, stagnantTicks);
+}
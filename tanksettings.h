@@ -0,0 +1,86 @@
+#ifndef TANKSETTINGS_H
+#define TANKSETTINGS_H
+
+#include <QDataStream>
+#include <QtGlobal>
+
+/**
+ * @brief Size and population of a training tank
+ *
+ * Saved with the tank so a run carries on with the settings it was
+ * started with. Battles, the arena and the league always use the
+ * defaults so their results can be compared.
+ *
+ * A tile size above 0 splits the tank into square tiles whose worms
+ * plan their moves on different threads, see TankTiles.
+ *
+ * A training generation where nothing has been eaten and no worm has
+ * died for stagnantTicks is checked for every worm going round a loop,
+ * and if they all are the ticks until a worm dies or gets shorter are
+ * skipped. The tank ends up as a full run would have it.
+ */
+struct TankSettings
+{
+    TankSettings() :
+        width(200),
+        height(200),
+        startFood(400),
+        startWorms(100),
+        foodEnergy(400),
+        survivors(10),
+        tileSize(0),
+        stagnantTicks(0)
+    {
+    }
+
+    int width;
+    int height;
+    uint startFood;
+    uint startWorms;
+    uint foodEnergy;
+    uint survivors;     // Worms kept at the end of a generation to breed the next
+    int tileSize;       // Width and height of the tiles, 0 for no tiles
+    uint stagnantTicks; // Quiet ticks before looking for worms going round loops, 0 to never
+
+    static const int MinSize = 50;
+    static const int MaxSize = 4096;
+    static const uint MaxWorms = 100000;
+    static const int MinTileSize = 32;
+    static const uint MinStagnantTicks = 100;
+
+    void limit();
+
+    bool operator==(const TankSettings &other) const
+    {
+        return width == other.width && height == other.height && startFood == other.startFood
+                && startWorms == other.startWorms && foodEnergy == other.foodEnergy && survivors == other.survivors
+                && tileSize == other.tileSize && stagnantTicks == other.stagnantTicks;
+    }
+    bool operator!=(const TankSettings &other) const {return !(*this == other);}
+
+    void save(QDataStream &out) const
+    {
+        out << width << height << startFood << startWorms << foodEnergy << survivors << tileSize << stagnantTicks;
+    }
+    /**
+     * @brief Read the settings saved with a tank
+     * @param in stream to read from
+     * @param fileVersion version of the tank file, the tile size was added
+     * in 3 and the stagnant ticks in 4
+     */
+    void load(QDataStream &in, int fileVersion)
+    {
+        in >> width >> height >> startFood >> startWorms >> foodEnergy >> survivors;
+        if (fileVersion >= 3) in >> tileSize;
+        if (fileVersion >= 4) in >> stagnantTicks;
+        limit();
+    }
+};
+
+inline QDataStream &operator<<(QDataStream &out, const TankSettings &settings)
+{
+    settings.save(out);
+    return out;
+}
+
+#endif // TANKSETTINGS_H
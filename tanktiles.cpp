@@ -0,0 +1,55 @@
+#include "tanktiles.h"
+#include "worm.h"
+
+TankTiles::TankTiles() :
+    m_tileSize(0),
+    m_columns(0)
+{
+}
+
+/**
+ * @brief Set the size of the tank and its tiles
+ * @param width width of the tank
+ * @param height height of the tank
+ * @param tileSize width and height of a tile, 0 for no tiles
+ */
+void TankTiles::setLayout(int width, int height, int tileSize)
+{
+    m_tileSize = tileSize;
+    m_tileWorms.clear();
+    if (m_tileSize <= 0)
+    {
+        m_columns = 0;
+        return;
+    }
+    m_columns = (width + m_tileSize - 1) / m_tileSize;
+    int rows = (height + m_tileSize - 1) / m_tileSize;
+    m_tileWorms.resize(m_columns * rows);
+}
+
+/**
+ * @brief Give each worm to the tile its head is in
+ *
+ * The worms of each tile are kept in the same order as in the list,
+ * so the layout doesn't change the order moves are made in.
+ *
+ * @param worms all the worms in the tank
+ */
+void TankTiles::assignWorms(const std::vector<Worm *> &worms)
+{
+    for (auto &tileWorms : m_tileWorms) tileWorms.clear();
+    for (uint j = 0; j < worms.size(); j++)
+    {
+        m_tileWorms[tileFor(worms[j]->headPos())].push_back(j);
+    }
+}
+
+/**
+ * @brief Get the bytes used by the worm lists of the tiles
+ */
+size_t TankTiles::memoryBytes() const
+{
+    size_t bytes = m_tileWorms.capacity() * sizeof(std::vector<uint>);
+    for (auto &tileWorms : m_tileWorms) bytes += tileWorms.capacity() * sizeof(uint);
+    return bytes;
+}
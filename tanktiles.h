@@ -0,0 +1,48 @@
+#ifndef TANKTILES_H
+#define TANKTILES_H
+
+#include <QPoint>
+#include <vector>
+
+class Worm;
+
+/**
+ * @brief Splits a tank into square tiles and the worms between them
+ *
+ * Each tick the worms are given to the tile their head is in, and the
+ * worms of a tile plan their moves together on one thread. Worms near
+ * the edge of a tile sense the cells of the tiles around it directly,
+ * as nothing in the tank changes while moves are being planned.
+ *
+ * Tiles along the right and bottom edges are smaller when the tank is
+ * not a whole number of tiles.
+ */
+class TankTiles
+{
+public:
+    TankTiles();
+
+    void setLayout(int width, int height, int tileSize);
+    bool active() const {return m_tileSize > 0;}
+    uint numTiles() const {return m_tileWorms.size();}
+
+    /**
+     * @brief Get the tile a cell is in
+     */
+    inline uint tileFor(QPoint pt) const {return (pt.y() / m_tileSize) * m_columns + pt.x() / m_tileSize;}
+
+    void assignWorms(const std::vector<Worm *> &worms);
+    /**
+     * @brief Get the indexes in the tank's worm list of the worms in a tile
+     */
+    const std::vector<uint> &tileWorms(uint tile) const {return m_tileWorms[tile];}
+
+    size_t memoryBytes() const;
+
+private:
+    int m_tileSize;
+    int m_columns;
+    std::vector<std::vector<uint> > m_tileWorms; // Worm indexes for each tile, in worm order
+};
+
+#endif // TANKTILES_H
@@ -1,6 +1,10 @@
 #include "worm.h"
 #include <cstdlib>
+#include <algorithm>
 #include "brain.h"
+#include "wormtank.h"
+#include "memoryusage.h"
+#include <QElapsedTimer>
 
 /*
  Name of positions for WormList table
@@ -59,7 +63,8 @@ QRgb PositionColours[MIX_COLOUR + 1] =
 Worm::Worm(WormTank *tank, const char *brainName, const QPoint &start, int dir) :
     m_tank(tank),
     m_colour(WORM_COLOUR),
-    m_dir(dir), m_energy(1000)
+    m_dir(dir), m_energy(1000),
+    m_moveCost(nullptr)
 {
     m_brain = BrainFactory::create(this, brainName);
     m_body.push_front(start);
@@ -70,26 +75,61 @@ Worm::Worm(WormTank *tank) :
     m_colour(WORM_COLOUR),
     m_brain(nullptr),
     m_dir(0),
-    m_energy(0)
+    m_energy(0),
+    m_moveCost(nullptr)
 {
 }
 
-Worm::Worm(const Worm &other) :
-	m_tank(other.m_tank),
-    m_colour(other.m_colour),
-	m_dir(other.m_dir),
-	m_energy(other.m_energy)
+Worm::~Worm()
 {
-    m_brain = other.m_brain->clone(this);
-	for (auto pt : other.m_body)
-	{
-		m_body.push_back(pt);
-	}
+    delete m_brain;
 }
 
-Worm::~Worm()
+/**
+ * @brief Make a child with a copy of this worm's brain
+ *
+ * The child is made from a spare worm in the tank if there is one. If
+ * the spare worm's brain is the same type it is copied into, keeping
+ * its storage, otherwise a new one is made. The body is left empty as
+ * it is about to be given a new position.
+ *
+ * @return the child
+ */
+Worm *Worm::newChild() const
 {
-    delete m_brain;
+    Worm *child = m_tank->newWorm();
+    child->m_colour = m_colour;
+    child->m_dir = m_dir;
+    child->m_energy = m_energy;
+    if (child->m_brain == nullptr || !child->m_brain->copyFrom(*m_brain))
+    {
+        delete child->m_brain;
+        child->m_brain = m_brain->clone(child);
+    }
+    return child;
+}
+
+/**
+ * @brief Empty the body so the worm can be used again
+ *
+ * The body keeps its buffer and the brain is kept to copy the next
+ * worm's brain into, so the next worm doesn't have to allocate them.
+ */
+void Worm::clearForReuse()
+{
+    m_body.clear();
+    m_moveCost = nullptr;
+}
+
+/**
+ * @brief Add the memory used by the worm, its body and its brain
+ * @param usage where to add the bytes
+ */
+void Worm::memoryUsage(MemoryUsage &usage) const
+{
+    usage.add(MemoryUsage::Worms, sizeof(Worm));
+    usage.add(MemoryUsage::Bodies, m_body.capacity() * sizeof(QPoint));
+    if (m_brain) m_brain->memoryUsage(usage);
 }
 
 /**
@@ -130,9 +170,10 @@ void Worm::read(QDataStream &in)
     }
     QString brainName;
     in >> brainName;
-    delete [] m_brain;
+    delete m_brain;
     m_brain = nullptr;
     m_brain = BrainFactory::create(this, brainName.toStdString().c_str());
+    m_moveCost = nullptr;
     m_brain->read(in);
 }
 
@@ -159,11 +200,49 @@ void Worm::resetPosition(QPoint pt, int dir)
  * @param dir the direction taken to get to this point
  */
 void Worm::planMove(QPoint &pt, int &dir)
+{
+    quint64 nsecs;
+    planMove(pt, dir, nsecs);
+    addMoveCost(nsecs);
+}
+
+/**
+ * @brief Plan the next move for the worm without recording the time taken
+ *
+ * Only the worm and its brain are changed, so worms can plan their
+ * moves on different threads.
+ *
+ * @param pt the next point to go to
+ * @param dir the direction taken to get to this point
+ * @param nsecs set to the time taken, 0 if move costs are not enabled
+ */
+void Worm::planMove(QPoint &pt, int &dir, quint64 &nsecs)
 {
     dir = m_dir;
     pt = m_body.front();
+    nsecs = 0;
 
+    if (!MoveCosts::enabled())
+    {
+        m_brain->planMove(pt, dir);
+        return;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
     m_brain->planMove(pt, dir);
+    nsecs = timer.nsecsElapsed();
+}
+
+/**
+ * @brief Record the time taken to plan a move in the tank's move costs
+ * @param nsecs time taken to plan the move
+ */
+void Worm::addMoveCost(quint64 nsecs)
+{
+    if (!MoveCosts::enabled()) return;
+    if (m_moveCost == nullptr) m_moveCost = m_tank->moveCosts().costFor(m_brain->fullName(), m_brain->name());
+    m_moveCost->add(nsecs);
 }
 
 void Worm::OKtoMove(QPoint pt, int dir)
@@ -182,10 +261,18 @@ void Worm::useEnergy()
 	if (m_energy > 0) m_energy--;
 }
 
+/**
+ * @brief Use up energy all at once, stopping at none
+ * @param amount energy to use
+ */
+void Worm::useEnergy(uint amount)
+{
+    m_energy -= std::min(amount, m_energy);
+}
+
 bool Worm::getPointToErase(QPoint &pt)
 {
-    unsigned int bodyLength = m_energy / 100 + 2;
-	if (m_body.size() > bodyLength)
+	if (m_body.size() > bodyLength())
 	{
 		pt = m_body.back();
         m_body.pop_back();
@@ -196,7 +283,7 @@ bool Worm::getPointToErase(QPoint &pt)
 
 Worm *Worm::randomChild(int chance, int weight)
 {
-	Worm *child = new Worm(*this);
+	Worm *child = newChild();
 	child->m_brain->randomise(chance, weight);
     if (m_colour >= LEADER_COLOUR && m_colour <= LEADER_COLOUR+10)
         child->m_colour = m_colour+CHILD_OFFSET;
@@ -205,7 +292,7 @@ Worm *Worm::randomChild(int chance, int weight)
 
 Worm *Worm::averageChild(Worm *mate, int chance, int weight)
 {
-    Worm *child = new Worm(*this);
+    Worm *child = newChild();
     child->m_brain->average(mate->m_brain);
     if (chance > 0 && weight > 0) child->m_brain->randomise(chance, weight);
     child->m_colour = AVERAGE_COLOUR;
@@ -214,9 +301,19 @@ Worm *Worm::averageChild(Worm *mate, int chance, int weight)
 
 Worm *Worm::mixChild(Worm *mate, int chance, int weight)
 {
-    Worm *child = new Worm(*this);
+    Worm *child = newChild();
     child->m_brain->mix(mate->m_brain);
     if (chance > 0 && weight > 0) child->m_brain->randomise(chance, weight);
     child->m_colour = MIX_COLOUR;
     return child;
 }
+
+/**
+ * @brief Randomly change the worms brain
+ * @param chance percentage chance that each element of the brain will change
+ * @param weight the amount of change
+ */
+void Worm::mutate(int chance, int weight)
+{
+    m_brain->randomise(chance, weight);
+}
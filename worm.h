@@ -2,13 +2,16 @@
 #define WORM_H
 
 #include "brain.h"
+#include "memorypool.h"
+#include "movecost.h"
+#include "wormbody.h"
 
 #include <QPoint>
 #include <QColor>
 #include <QDataStream>
-#include <deque>
 
 class WormTank;
+class MemoryUsage;
 
 // Background colour
 const int GROUND_COLOUR = 0;
@@ -41,8 +44,14 @@ public:
     Worm(WormTank *tank);
     ~Worm();
 
+    // Worms are made and thrown away every generation so come from the pool
+    static void *operator new(size_t size) {return MemoryPool::allocate(size);}
+    static void operator delete(void *ptr, size_t size) {MemoryPool::release(ptr, size);}
+
     std::string name() const {return m_brain->name();}
     std::string fullName() const {return m_brain->fullName();}
+    quint64 brainHash() const {return m_brain->contentHash();}
+    bool brainChangesWhenMoving() const {return m_brain->changesWhenMoving();}
 
     int colour() const {return m_colour;}
     void setColour(int colour) {m_colour = colour;}
@@ -53,6 +62,8 @@ public:
     WormTank *tank() {return m_tank;}
 
     void planMove(QPoint &pt, int &dir);
+    void planMove(QPoint &pt, int &dir, quint64 &nsecs);
+    void addMoveCost(quint64 nsecs);
     void OKtoMove(QPoint pt, int dir);
 
 	void clearTail();
@@ -61,28 +72,37 @@ public:
 
     uint energy() const {return m_energy;}
 	void useEnergy();
+    void useEnergy(uint amount);
     void feed(uint amount);
 	bool dead() const { return (m_energy == 0); }
 
     QPoint headPos() const {return m_body.front();}
+    int direction() const {return m_dir;}
+    uint bodyLength() const {return m_energy / 100 + 2;}
 	bool getPointToErase(QPoint &pt);
 
-    const std::deque<QPoint> &body() const { return m_body; }
+    const WormBody &body() const { return m_body; }
 
 	Worm *randomChild(int chance, int weight);
     Worm *averageChild(Worm *mate, int chance, int weight);
     Worm *mixChild(Worm *mate, int chance, int weight);
+    void mutate(int chance, int weight);
+
+    void clearForReuse();
+    void memoryUsage(MemoryUsage &usage) const;
 
 private:
-	Worm(const Worm &other);
+    Worm(const Worm &other); // Not copyable, children are made by newChild
+    Worm *newChild() const;
 
 private:
     WormTank *m_tank;
     int m_colour;
     Brain *m_brain;
 	int m_dir;
-    std::deque<QPoint> m_body;
+    WormBody m_body;
     uint m_energy;
+    MoveCost *m_moveCost; // Where to add the time taken by planMove, looked up on the first move
 };
 
 inline QDataStream &operator<<(QDataStream &out, Worm &worm)
@@ -0,0 +1,142 @@
+#ifndef WORMBODY_H
+#define WORMBODY_H
+
+#include "memorypool.h"
+#include <QPoint>
+#include <algorithm>
+#include <new>
+
+/**
+ * @brief Run of body cells that are next to each other in memory
+ */
+struct BodySpan
+{
+    const QPoint *cells;
+    uint count;
+};
+
+/**
+ * @brief Cells of a worm's body from the head to the tail
+ *
+ * The cells are kept in a ring buffer whose size is a power of 2, so
+ * the head can be added at the front and the tail removed from the back
+ * without moving anything. The buffer only grows, doubling, when the
+ * body is longer than it has ever been. Sensors that look at every cell
+ * can use spans() to get the cells as at most two plain arrays.
+ */
+class WormBody
+{
+public:
+    WormBody() : m_cells(nullptr), m_capacity(0), m_head(0), m_size(0) {}
+    WormBody(const WormBody &other) : m_cells(nullptr), m_capacity(0), m_head(0), m_size(0)
+    {
+        reserve(other.m_size);
+        for (auto pt : other) push_back(pt);
+    }
+    ~WormBody() {MemoryPool::release(m_cells, m_capacity * sizeof(QPoint));}
+
+    WormBody &operator=(const WormBody &other)
+    {
+        if (this != &other)
+        {
+            clear();
+            reserve(other.m_size);
+            for (auto pt : other) push_back(pt);
+        }
+        return *this;
+    }
+
+    uint size() const {return m_size;}
+    uint capacity() const {return m_capacity;}
+    bool empty() const {return m_size == 0;}
+
+    const QPoint &operator[](uint idx) const {return m_cells[(m_head + idx) & (m_capacity - 1)];}
+    const QPoint &front() const {return m_cells[m_head];}
+    const QPoint &back() const {return (*this)[m_size - 1];}
+
+    void push_front(QPoint pt)
+    {
+        if (m_size == m_capacity) reserve(m_size + 1);
+        m_head = (m_head - 1) & (m_capacity - 1);
+        m_cells[m_head] = pt;
+        m_size++;
+    }
+
+    void push_back(QPoint pt)
+    {
+        if (m_size == m_capacity) reserve(m_size + 1);
+        m_cells[(m_head + m_size) & (m_capacity - 1)] = pt;
+        m_size++;
+    }
+
+    void pop_back() {m_size--;}
+    void clear() {m_size = 0; m_head = 0;}
+
+    /**
+     * @brief Get the cells as plain arrays
+     * @param spans array of 2 to set to the runs of cells, head first
+     * @return number of spans set
+     */
+    uint spans(BodySpan *spans) const
+    {
+        if (m_size == 0) return 0;
+        uint firstCount = std::min(m_size, m_capacity - m_head);
+        spans[0].cells = m_cells + m_head;
+        spans[0].count = firstCount;
+        if (firstCount == m_size) return 1;
+        spans[1].cells = m_cells;
+        spans[1].count = m_size - firstCount;
+        return 2;
+    }
+
+    /**
+     * @brief Iterator over the cells from the head to the tail
+     */
+    class const_iterator
+    {
+    public:
+        const_iterator(const WormBody *body, uint idx) : m_body(body), m_idx(idx) {}
+        const QPoint &operator*() const {return (*m_body)[m_idx];}
+        const QPoint *operator->() const {return &(*m_body)[m_idx];}
+        const_iterator &operator++() {m_idx++; return *this;}
+        const_iterator operator+(uint offset) const {return const_iterator(m_body, m_idx + offset);}
+        bool operator==(const const_iterator &other) const {return m_idx == other.m_idx;}
+        bool operator!=(const const_iterator &other) const {return m_idx != other.m_idx;}
+
+    private:
+        const WormBody *m_body;
+        uint m_idx;
+    };
+
+    const_iterator begin() const {return const_iterator(this, 0);}
+    const_iterator end() const {return const_iterator(this, m_size);}
+
+private:
+    /**
+     * @brief Make room for at least a number of cells
+     *
+     * The cells are moved to the start of the new buffer.
+     */
+    void reserve(uint count)
+    {
+        if (count <= m_capacity) return;
+        uint capacity = m_capacity ? m_capacity : MinCapacity;
+        while (capacity < count) capacity *= 2;
+
+        QPoint *cells = static_cast<QPoint *>(MemoryPool::allocate(capacity * sizeof(QPoint)));
+        for (uint j = 0; j < m_size; j++) new (cells + j) QPoint((*this)[j]);
+        MemoryPool::release(m_cells, m_capacity * sizeof(QPoint));
+        m_cells = cells;
+        m_capacity = capacity;
+        m_head = 0;
+    }
+
+private:
+    static const uint MinCapacity = 16;
+    QPoint *m_cells;
+    uint m_capacity;
+    uint m_head;
+    uint m_size;
+};
+
+#endif // WORMBODY_H
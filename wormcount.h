@@ -12,13 +12,17 @@ class WormCount : public QObject
     Q_PROPERTY(QString colourName READ colourName NOTIFY colourNameChanged)
     Q_PROPERTY(QColor colour READ colour NOTIFY colourChanged)
     Q_PROPERTY(uint count READ count NOTIFY countChanged)
+    Q_PROPERTY(double meanMoveTime READ meanMoveTime NOTIFY moveTimeChanged)
+    Q_PROPERTY(double p99MoveTime READ p99MoveTime NOTIFY moveTimeChanged)
 
 public:
     explicit WormCount(QString name, int colourIndex, QObject *parent = 0) :
         QObject(parent),
         m_name(name),
         m_colourIndex(colourIndex),
-        m_count(1)
+        m_count(1),
+        m_meanMoveTime(0),
+        m_p99MoveTime(0)
     {
 
     }
@@ -28,6 +32,9 @@ public:
     QColor colour() const {return PositionColours[m_colourIndex];}
     int colourIndex() const {return m_colourIndex;}
     uint count() const {return m_count;}
+    // Microseconds to plan a move in the last generation
+    double meanMoveTime() const {return m_meanMoveTime;}
+    double p99MoveTime() const {return m_p99MoveTime;}
 
     void setName(QString name)
     {
@@ -63,11 +70,22 @@ public:
         emit countChanged(m_count);
     }
 
+    void setMoveTimes(double mean, double p99)
+    {
+        if (mean != m_meanMoveTime || p99 != m_p99MoveTime)
+        {
+            m_meanMoveTime = mean;
+            m_p99MoveTime = p99;
+            emit moveTimeChanged();
+        }
+    }
+
 signals:
     void nameChanged(QString name);
     void countChanged(uint changed);
     void colourChanged(QColor colour);
     void colourNameChanged(QString colourName);
+    void moveTimeChanged();
 
 public slots:
 
@@ -75,6 +93,8 @@ private:
     QString m_name;
     int m_colourIndex;
     uint m_count;
+    double m_meanMoveTime;
+    double m_p99MoveTime;
 };
 
 #endif // WORMCOUNT_H
@@ -5,34 +5,78 @@
 #include <cstdlib>
 #include <cmath>
 #include <algorithm>
+#include <unordered_set>
 #include <QDir>
 #include <QFile>
 #include <QStandardPaths>
 #include <QMessageBox>
+#include <QThread>
+#include <QMutexLocker>
+#include <QRunnable>
+#include <atomic>
 
+thread_local WormTank::SensorScratch *WormTank::s_threadScratch = nullptr;
+const uint WormTank::MinCycleWindow;
+const uint WormTank::MaxCycleWindow;
+
+/**
+ * @brief Plans the moves of the worms in the tiles handed out to it
+ *
+ * Tiles are taken in turn from a shared counter, so a thread that
+ * finishes a quiet tile goes on to the next one.
+ */
+class TilePlanner : public QRunnable
+{
+public:
+    TilePlanner(WormTank *tank, WormTank::SensorScratch *scratch, std::atomic<uint> *nextTile, uint numTiles) :
+        m_tank(tank),
+        m_scratch(scratch),
+        m_nextTile(nextTile),
+        m_numTiles(numTiles)
+    {
+    }
+
+    virtual void run()
+    {
+        WormTank::setThreadScratch(m_scratch);
+        for (uint tile = (*m_nextTile)++; tile < m_numTiles; tile = (*m_nextTile)++)
+        {
+            m_tank->planTileMoves(tile);
+        }
+        WormTank::setThreadScratch(nullptr);
+    }
+
+private:
+    WormTank *m_tank;
+    WormTank::SensorScratch *m_scratch;
+    std::atomic<uint> *m_nextTile;
+    uint m_numTiles;
+};
 
 WormTank::WormTank(QObject *parent) :
     QObject(parent),
     m_mode(WormTank::NormalMode),
     m_name("Simple"),
     m_generation(0),
-    m_width(200),
-    m_height(200),
-    m_startFood(400),
-    m_startWorms(100),
-    m_foodEnergy(400),
+    m_width(0),
+    m_height(0),
     m_survivors(10),
-    m_tankImage(m_width, m_height, QImage::Format_Indexed8),
+    m_tileSize(0),
+    m_stagnantTicks(0),
+    m_foodEaten(0),
+    m_ateThisStep(false),
+    m_cellVersion(1),
+    m_randomSeeds(0),
+    m_quietTicks(0),
+    m_loopPeriod(0),
+    m_snapshotTick(0),
+    m_loopRepeated(false),
+    m_genomes(0),
+    m_lastGenerationAllocations(0),
+    m_lastGenerationAllocatedBytes(0),
     m_league(nullptr)
 {
-    for (int j = 0; j < NUM_POSITIONS; j++)
-	{
-		m_tankImage.setColor(j, PositionColours[j]);
-	}
-    m_tankImage.fill(GROUND_COLOUR);
-
-    // Cache the maximum distance for speed
-    m_maxDistance = int(std::sqrt(m_width * m_width + m_height * m_height)) + 1;
+    setSettings(TankSettings());
 }
 
 WormTank::~WormTank()
@@ -41,9 +85,31 @@ WormTank::~WormTank()
     {
         delete worm;
     }
+    for (auto worm : m_spareWorms)
+    {
+        delete worm;
+    }
     delete m_league;
 }
 
+/**
+ * @brief Hand out a seed for a brain's own random generator
+ *
+ * Kept separate from std::rand so that building random brains doesn't
+ * change the sequence the other brains are bred from.
+ *
+ * @return non-zero seed
+ */
+quint64 WormTank::nextRandomSeed()
+{
+    // splitmix64 of a counter
+    quint64 seed = (m_randomSeeds += 0x9E3779B97F4A7C15ULL);
+    seed = (seed ^ (seed >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    seed = (seed ^ (seed >> 27)) * 0x94D049BB133111EBULL;
+    seed ^= seed >> 31;
+    return seed ? seed : 1;
+}
+
 /**
  * @brief Get QColour for an index
  * @param index of colour to return (use _COLOUR constants)
@@ -51,7 +117,7 @@ WormTank::~WormTank()
  */
 QColor WormTank::colourForIndex(int index)
 {
-    return m_tankImage.color(index);
+    return QColor(PositionColours[index]);
 }
 
 
@@ -65,7 +131,7 @@ void WormTank::start(QString wormType, bool resetTank)
     m_mode = NormalMode;
     setName(wormType);
     if (resetTank || !loadLatest(wormType)) reset(wormType);
-    m_survivors = 10;
+    m_survivors = m_trainingSurvivors;
 }
 
 /**
@@ -84,6 +150,7 @@ void WormTank::startBattle(QString wormType1, QString wormType2, bool reset)
 
     m_mode = BattleMode;
     setName(name);
+    setSettings(TankSettings());
 	clear();
 	if (reset)
 	{
@@ -136,6 +203,7 @@ void WormTank::startArena()
 
     m_mode = ArenaMode;
     setName(name);
+    setSettings(TankSettings());
     clear();
 
     int colour = TEAM1_COLOUR;
@@ -235,6 +303,7 @@ QString WormTank::leagueWinner() const
 void WormTank::startLeague()
 {
     m_mode = LeagueMode;
+    setSettings(TankSettings());
     clear();
     if (!loadLeague() || leagueWon())
     {
@@ -268,6 +337,15 @@ QObject *WormTank::history()
     return &m_history;
 }
 
+/**
+ * @brief Get memory used by each part of the tank for QML
+ * @return memory usage list, updated at the end of each generation
+ */
+QObject *WormTank::memoryUsage()
+{
+    return &m_memoryUsage;
+}
+
 /**
  * @brief Number of ticks in the last generation
  * @return number of ticks or 0 if first generation
@@ -300,13 +378,148 @@ uint WormTank::lastGenerationMaxEnergy() const
  */
 void WormTank::clear()
 {
-    m_tankImage.fill(GROUND_COLOUR);
+    m_grid.clear();
+    m_cellVersion++;
+    m_foodIndex.clear();
+    m_wormIndex.clear();
+    m_foodDistance.clear();
     for (auto worm : m_worms)
     {
-        delete worm;
+        recycleWorm(worm);
     }
     m_worms.clear();
     m_food.clear();
+    m_foodEaten = 0;
+    resetStagnation();
+}
+
+/**
+ * @brief Get the settings the tank is running with
+ */
+TankSettings WormTank::settings() const
+{
+    TankSettings settings;
+    settings.width = m_width;
+    settings.height = m_height;
+    settings.startFood = m_startFood;
+    settings.startWorms = m_startWorms;
+    settings.foodEnergy = m_foodEnergy;
+    settings.survivors = m_trainingSurvivors;
+    settings.tileSize = m_tileSize;
+    settings.stagnantTicks = m_stagnantTicks;
+    return settings;
+}
+
+/**
+ * @brief Change the size and population of the tank
+ *
+ * Changing the size empties the grid and the indexes, so the tank must
+ * be cleared or set up again afterwards.
+ *
+ * @param settings new settings, brought into range first
+ */
+void WormTank::setSettings(const TankSettings &settings)
+{
+    TankSettings limited = settings;
+    limited.limit();
+    if (limited.width != m_width || limited.height != m_height) setSize(limited.width, limited.height);
+    m_startFood = limited.startFood;
+    m_startWorms = limited.startWorms;
+    m_foodEnergy = limited.foodEnergy;
+    m_trainingSurvivors = limited.survivors;
+    m_tileSize = limited.tileSize;
+    m_stagnantTicks = limited.stagnantTicks;
+    m_tiles.setLayout(m_width, m_height, m_tileSize);
+}
+
+/**
+ * @brief Set the settings used the next time a training tank is reset
+ * @param settings new settings, brought into range first
+ */
+void WormTank::setNewTankSettings(const TankSettings &settings)
+{
+    m_newTankSettings = settings;
+    m_newTankSettings.limit();
+}
+
+/**
+ * @brief Make a new empty grid and indexes for a tank size
+ * @param width width of the tank
+ * @param height height of the tank
+ */
+void WormTank::setSize(int width, int height)
+{
+    m_width = width;
+    m_height = height;
+    m_grid.setSize(m_width, m_height, GROUND_COLOUR);
+    m_cellVersion++;
+    m_cellOffsets[0] = m_grid.rowOffset();
+    m_cellOffsets[1] = 1;
+    m_cellOffsets[2] = -m_grid.rowOffset();
+    m_cellOffsets[3] = -1;
+    m_foodIndex.setSize(m_width, m_height);
+    m_wormIndex.setSize(m_width, m_height);
+    m_foodDistance.setSize(m_width, m_height);
+
+    // Cache the maximum distance for speed
+    m_maxDistance = int(std::sqrt(m_width * m_width + m_height * m_height)) + 1;
+}
+
+/**
+ * @brief Set the colour of a cell in the tank
+ *
+ * All changes to the tank grid should go through here so the
+ * food and worm indexes and the food distance field are kept up to date.
+ *
+ * @param pt cell to set
+ * @param colour new colour for the cell
+ */
+void WormTank::setCell(QPoint pt, int colour)
+{
+    int idx = cellIndex(pt);
+    int oldColour = cellAt(idx);
+    if (oldColour == FOOD_COLOUR) m_foodIndex.remove(pt);
+    else if (oldColour >= WORM_COLOUR) m_wormIndex.remove(pt);
+
+    m_grid.set(idx, colour);
+    m_cellVersion++;
+
+    if (colour == FOOD_COLOUR) m_foodIndex.insert(pt);
+    else if (colour >= WORM_COLOUR) m_wormIndex.insert(pt);
+
+    m_foodDistance.setState(pt, distanceState(colour));
+}
+
+/**
+ * @brief Get the colours of the cells checked by the next to sensors
+ *
+ * The food and worm next to sensors look at the same three cells, so
+ * the colours are read once and kept until the worm or the tank changes.
+ * The cells are found by moving left, then ahead, then right from the
+ * head, each move starting where the last one finished.
+ *
+ * @param pt Worm head position
+ * @param dir direction worm is facing
+ * @return array of 3 colours for left, ahead and right, -1 if outside the tank
+ */
+const int *WormTank::nextToCells(QPoint pt, int dir)
+{
+    SensorScratch &scratch = sensorScratch();
+    if (scratch.nextToVersion == m_cellVersion && scratch.nextToPt == pt && scratch.nextToDir == dir) return scratch.nextToCells;
+
+    int moveDir[3] = {(dir + 3) % 4, dir, (dir + 1) % 4};
+    QPoint check(pt);
+    int idx = cellIndex(pt);
+    for (int j = 0; j < 3; j++)
+    {
+        movePoint(check, moveDir[j]);
+        idx += m_cellOffsets[moveDir[j]];
+        scratch.nextToCells[j] = pointInTank(check) ? cellAt(idx) : -1;
+    }
+    scratch.nextToVersion = m_cellVersion;
+    scratch.nextToPt = pt;
+    scratch.nextToDir = dir;
+    return scratch.nextToCells;
 }
 
 /**
@@ -314,16 +527,17 @@ void WormTank::clear()
  */
 void WormTank::setupTank()
 {
+    m_moveCosts.clear();
     for (auto foodPos : m_food)
     {
-        m_tankImage.setPixel(foodPos, FOOD_COLOUR);
+        setCell(foodPos, FOOD_COLOUR);
     }
     // Draw worms still alive
     for (auto worm : m_worms)
     {
         for (auto wormPos : worm->body())
         {
-            m_tankImage.setPixel(wormPos, worm->colour());
+            setCell(wormPos, worm->colour());
         }
     }
 
@@ -340,6 +554,9 @@ void WormTank::setupTank()
     emit lastGenerationTicksChanged(lastGenerationTicks());
     emit lastGenerationFoodLeftChanged(lastGenerationFoodLeft());
     emit lastGenerationMaxEnergyChanged(lastGenerationMaxEnergy());
+    setGenomes(countGenomes());
+    m_memoryUsage.clearPeaks();
+    measureMemory();
 }
 
 /**
@@ -451,7 +668,7 @@ void WormTank::addNewWorms(QString wormType, int colour, uint count)
         QPoint wormPos = getEmptyPos();
         Worm *worm = new Worm(this, brainName.c_str(), wormPos, randBetween(0, 3));
         worm->setColour(colour);
-        m_tankImage.setPixel(wormPos, colour);
+        setCell(wormPos, colour);
         m_worms.push_back(worm);
     }
 }
@@ -466,7 +683,7 @@ void WormTank::addFood(uint count)
     {
         QPoint foodPos = getEmptyPos();
         m_food.push_back(foodPos);
-        m_tankImage.setPixel(foodPos, FOOD_COLOUR);
+        setCell(foodPos, FOOD_COLOUR);
     }
 }
 
@@ -480,9 +697,9 @@ void WormTank::moveFoodFromEdges()
 		if (foodPos.x() < 10 || foodPos.x() > m_width - 10
 			|| foodPos.y() < 10 || foodPos.y() > m_height - 10)
 		{
-			m_tankImage.setPixel(foodPos, GROUND_COLOUR);
+			setCell(foodPos, GROUND_COLOUR);
 			foodPos = getEmptyPos();
-			m_tankImage.setPixel(foodPos, FOOD_COLOUR);
+			setCell(foodPos, FOOD_COLOUR);
 		}
 	}
 }
@@ -496,7 +713,7 @@ void WormTank::clearExcessFood()
     {
         for (auto food = m_food.begin() + m_startFood; food != m_food.end(); ++food)
         {
-            m_tankImage.setPixel(*food, GROUND_COLOUR);
+            setCell(*food, GROUND_COLOUR);
         }
         m_food.erase(m_food.begin() + m_startFood, m_food.end());
     }
@@ -510,6 +727,7 @@ void WormTank::clearExcessFood()
  */
 void WormTank::reset(QString wormType)
 {
+    setSettings(m_newTankSettings);
     clear();
     setName(wormType);
 
@@ -517,7 +735,7 @@ void WormTank::reset(QString wormType)
     for (uint j = 0; j < m_startFood; j++)
     {
         QPoint foodPos = getEmptyPos();
-        m_tankImage.setPixel(foodPos, FOOD_COLOUR);
+        setCell(foodPos, FOOD_COLOUR);
         m_food.push_back(foodPos);
     }
 
@@ -533,6 +751,7 @@ void WormTank::setFirstGenerationVars()
     m_generation = 1;
     m_tick = 0;
     m_history.clear();
+    m_moveCosts.clear();
     emit generationChanged(m_generation);
     emit tickChanged(m_tick);
     setMaxEnergy(0);
@@ -543,6 +762,9 @@ void WormTank::setFirstGenerationVars()
     emit lastGenerationTicksChanged(0);
     emit lastGenerationFoodLeftChanged(m_startFood);
     emit lastGenerationMaxEnergyChanged(0);
+    setGenomes(countGenomes());
+    m_memoryUsage.clearPeaks();
+    measureMemory();
 }
 
 
@@ -634,9 +856,10 @@ void WormTank::save(QString fileName)
     if (saveFile.open(QIODevice::WriteOnly))
     {
         QDataStream out(&saveFile);
-        int fileVersion = 1;
+        int fileVersion = 4;
         out << fileVersion;
         out << int(m_mode);
+        out << settings();
         out << m_name;
         out << m_generation;
         out << m_tick;
@@ -676,6 +899,14 @@ bool WormTank::load(QString fileName)
         in >> fileVersion;       
         in >> fileType;
         m_mode = Mode(fileType);
+
+        // Size the tank before reading the worms, as brains set up their
+        // sensors from it. Files from before the settings were saved used
+        // the defaults
+        TankSettings settings;
+        if (fileVersion >= 2) settings.load(in, fileVersion);
+        setSettings(settings);
+
         in >> m_name;
         in >> m_generation;
         in >> m_tick;
@@ -684,7 +915,7 @@ bool WormTank::load(QString fileName)
         m_worms.clear();
         for (uint j = 0; j < m_wormsLeft; j++)
         {
-            Worm *worm = new Worm(this);
+            Worm *worm = newWorm();
             in >> *worm;
             m_worms.push_back(worm);
         }
@@ -728,6 +959,8 @@ bool WormTank::loadWorms(QString wormType, int colour, uint count)
         int fileVersion, fileType;
         in >> fileVersion;
         in >> fileType;
+        TankSettings settings;
+        if (fileVersion >= 2) settings.load(in, fileVersion); // Skip settings
         QString name;
         in >> name; // Skip name
         uint dum;
@@ -737,20 +970,38 @@ bool WormTank::loadWorms(QString wormType, int colour, uint count)
         uint wormsLeft;
         in >> wormsLeft;
         if (count > wormsLeft) count = wormsLeft;
-        for (uint j = 0; j < count; j++)
+
+        // Skip worms with the same brain as one already loaded so a
+        // team isn't made up of clones, unless there aren't enough others
+        std::vector<Worm *> loaded;
+        std::vector<Worm *> clones;
+        std::unordered_set<quint64> genomes;
+        for (uint j = 0; j < wormsLeft && loaded.size() < count; j++)
         {
-            Worm *worm = new Worm(this);
+            Worm *worm = newWorm();
             in >> *worm;
+            if (genomes.insert(worm->brainHash()).second) loaded.push_back(worm);
+            else clones.push_back(worm);
+        }
+        for (uint j = 0; j < clones.size(); j++)
+        {
+            if (loaded.size() < count) loaded.push_back(clones[j]);
+            else recycleWorm(clones[j]);
+        }
+
+        for (auto worm : loaded)
+        {
             worm->setColour(colour);
             worm->clearTail();
             worm->resetEnergy();
             m_worms.push_back(worm);
-            if (m_tankImage.pixelIndex(worm->headPos()))
+            if (!pointInTank(worm->headPos()) || cellAt(cellIndex(worm->headPos())))
             {
                 // Reposition so it's not loaded on top of something else
+                // or outside a tank of a different size
                 worm->resetPosition(getEmptyPos(), std::rand() & 3);
             }
-            m_tankImage.setPixel(worm->headPos(), worm->colour());
+            setCell(worm->headPos(), worm->colour());
         }
 
         fileLoaded = true;
@@ -777,6 +1028,8 @@ uint WormTank::latestGeneration(QString wormType)
             int fileVersion, fileType;
             in >> fileVersion;
             in >> fileType;
+            TankSettings settings;
+            if (fileVersion >= 2) settings.load(in, fileVersion); // Skip settings
             QString name;
             in >> name; // Skip name
             in >> generation;
@@ -826,6 +1079,15 @@ void WormTank::setMaxEnergy(unsigned int energy)
     }
 }
 
+void WormTank::setGenomes(uint genomes)
+{
+    if (m_genomes != genomes)
+    {
+        m_genomes = genomes;
+        emit genomesChanged(genomes);
+    }
+}
+
 void WormTank::setLeaderAge(unsigned int age)
 {
     if (m_leaderAge != age)
@@ -860,20 +1122,37 @@ void WormTank::step()
        if (m_foodLeft < 10) addFood(10);
     }
 
-	for (auto worm : m_worms)
+    m_ateThisStep = false;
+    bool tiled = m_tiles.active();
+    if (tiled) planMovesInTiles();
+
+	for (uint w = 0; w < m_worms.size(); w++)
 	{
-        worm->planMove(pt, dir);
+        Worm *worm = m_worms[w];
+        if (tiled)
+        {
+            // Moves were all planned before any worm moved, so the first
+            // worm in the list to get to a cell takes it and the rest collide
+            const PlannedMove &move = m_plannedMoves[w];
+            pt = move.pt;
+            dir = move.dir;
+            worm->addMoveCost(move.nsecs);
+        } else
+        {
+            worm->planMove(pt, dir);
+        }
         if (pt.x() >= 0 && pt.x() < m_width && pt.y() >= 0 && pt.y() < m_height)
 		{
-            int pixel = m_tankImage.pixelIndex(pt);
+            int pixel = cellAt(cellIndex(pt));
             if (pixel == GROUND_COLOUR || pixel == FOOD_COLOUR)
 			{
                 worm->OKtoMove(pt,dir);
-                m_tankImage.setPixel(pt, worm->colour());
+                setCell(pt, worm->colour());
 				if (pixel == FOOD_COLOUR)
 				{
-                    auto pos = std::find(m_food.begin(), m_food.end(), pt);
-                    m_food.erase(pos);
+                    // Taken out of m_food once the step is over
+                    m_foodEaten++;
+                    m_ateThisStep = true;
 					worm->feed(m_foodEnergy);
                     if (worm->energy() > m_maxEnergy) setMaxEnergy(worm->energy());
                 }
@@ -887,7 +1166,7 @@ void WormTank::step()
 		worm->useEnergy();
         while (worm->getPointToErase(pt))
         {
-            m_tankImage.setPixel(pt, GROUND_COLOUR);
+            setCell(pt, GROUND_COLOUR);
         }
         if (worm->dead())
         {
@@ -897,19 +1176,9 @@ void WormTank::step()
         }
 	}
 
-	// Get rid of dead worms and convert them to food
-	for (auto worm : died)
-	{
-        auto pos = std::find(m_worms.begin(), m_worms.end(), worm);
-        m_worms.erase(pos);
-		// Convert dead body to food
-		for (auto pt : worm->body())
-		{
-			m_tankImage.setPixel(pt, FOOD_COLOUR);
-			m_food.push_back(pt);
-		}
-        delete worm;
-	}
+    bool quiet = (!m_ateThisStep && died.empty());
+    removeEatenFood();
+    removeDeadWorms(died);
 
     setWormsLeft(m_worms.size());
     setFoodLeft(m_food.size());
@@ -939,6 +1208,11 @@ void WormTank::step()
         }
     }
 
+    if (!genFinished && m_mode == NormalMode && m_survivors > 0 && m_stagnantTicks > 0)
+    {
+        checkStagnation(quiet);
+    }
+
     if (genFinished)
 	{
 		nextGeneration();
@@ -949,11 +1223,264 @@ void WormTank::step()
 	}
 }
 
+/**
+ * @brief Take dead worms out of the tank, turning their bodies into food
+ * @param died worms that have died, in the order they are in m_worms
+ */
+void WormTank::removeDeadWorms(const std::vector<Worm *> &died)
+{
+    if (died.empty()) return;
+
+    // Get rid of dead worms in one pass
+    size_t kept = 0;
+    size_t nextDied = 0;
+    for (auto worm : m_worms)
+    {
+        if (nextDied < died.size() && worm == died[nextDied]) nextDied++;
+        else m_worms[kept++] = worm;
+    }
+    m_worms.resize(kept);
+
+	// Convert dead worms to food
+	for (auto worm : died)
+	{
+		// Convert dead body to food
+		for (auto pt : worm->body())
+		{
+			setCell(pt, FOOD_COLOUR);
+			m_food.push_back(pt);
+		}
+        recycleWorm(worm);
+	}
+}
+
+/**
+ * @brief Skip ticks where the tank only repeats itself
+ *
+ * Once nothing has been eaten and no worm has died for m_stagnantTicks
+ * the worms are watched for going round loops. When they all are, the
+ * tank is checked for being back as it was after all the loops have
+ * gone round together. If it is, then until a worm dies or gets shorter
+ * the tank goes on repeating itself, so those ticks are skipped. The
+ * check is then made again from where the skip ended.
+ *
+ * @param quiet true if no food was eaten and no worm died this step
+ */
+void WormTank::checkStagnation(bool quiet)
+{
+    if (!quiet)
+    {
+        resetStagnation();
+        return;
+    }
+
+    m_quietTicks++;
+    if (m_quietTicks < m_stagnantTicks) return;
+    if (m_loopPeriod == 0)
+    {
+        if (!checkCycles()) return;
+        m_loopPeriod = commonLoopPeriod();
+        if (m_loopPeriod == 0) return;
+        m_loopRepeated = false;
+        takeSnapshot();
+    } else if (m_tick - m_snapshotTick == m_loopPeriod)
+    {
+        if (repeatsSnapshot())
+        {
+            fastForward();
+            m_loopRepeated = true;
+        } else if (m_loopRepeated)
+        {
+            // A worm got shorter since the last skip, so look again
+            m_loopRepeated = false;
+        } else
+        {
+            // Start the search for loops over
+            m_loopPeriod = 0;
+            m_snapshot.clear();
+            m_cycleChecks.clear();
+            return;
+        }
+        takeSnapshot();
+    }
+}
+
+/**
+ * @brief Stop looking for worms going round loops
+ */
+void WormTank::resetStagnation()
+{
+    m_quietTicks = 0;
+    m_cycleChecks.clear();
+    m_snapshot.clear();
+    m_loopPeriod = 0;
+    m_loopRepeated = false;
+}
+
+/**
+ * @brief Update the loop search for each worm
+ *
+ * Starts the search for every worm the first time it is called after
+ * the tank has gone quiet.
+ *
+ * @return true if all the worms are going round loops
+ */
+bool WormTank::checkCycles()
+{
+    bool starting = (m_cycleChecks.size() != m_worms.size());
+    if (starting) m_cycleChecks.assign(m_worms.size(), CycleCheck());
+
+    bool allCycling = true;
+    for (uint w = 0; w < m_worms.size(); w++)
+    {
+        Worm *worm = m_worms[w];
+        CycleCheck &check = m_cycleChecks[w];
+        QPoint head = worm->headPos();
+        quint64 state = (quint64(uint(head.x())) << 34) | (quint64(uint(head.y())) << 2) | uint(worm->direction());
+        if (starting)
+        {
+            check.window = MinCycleWindow;
+            check.period = 0;
+            check.drain = 0;
+            check.lastPathHash = 0;
+            check.cycling = false;
+        } else
+        {
+            uint elapsed = m_tick - check.startTick;
+            check.pathHash = (check.pathHash ^ state) * 0x100000001b3ULL;
+            if (state == check.start)
+            {
+                uint drain = check.startEnergy - worm->energy();
+                check.cycling = (elapsed == check.period && drain == check.drain && check.pathHash == check.lastPathHash);
+                check.period = elapsed;
+                check.drain = drain;
+                check.lastPathHash = check.pathHash;
+            } else if (elapsed >= check.window)
+            {
+                check.window = std::min(check.window * 2, MaxCycleWindow);
+                check.period = 0;
+                check.cycling = false;
+            } else
+            {
+                allCycling = allCycling && check.cycling;
+                continue;
+            }
+        }
+
+        // Start a new window from here
+        check.start = state;
+        check.pathHash = 0;
+        check.startTick = m_tick;
+        check.startEnergy = worm->energy();
+        allCycling = allCycling && check.cycling;
+    }
+    return allCycling;
+}
+
+/**
+ * @brief Get the ticks for all the worms to go round their loops together
+ *
+ * Worms whose brains change as they move never repeat themselves, so
+ * nothing can be skipped while there are any.
+ *
+ * @return ticks or 0 if there are none up to MaxCycleWindow
+ */
+uint WormTank::commonLoopPeriod() const
+{
+    quint64 period = 1;
+    for (uint w = 0; w < m_worms.size(); w++)
+    {
+        if (m_worms[w]->brainChangesWhenMoving()) return 0;
+        quint64 loop = m_cycleChecks[w].period;
+        quint64 a = period, b = loop;
+        while (b) {quint64 r = a % b; a = b; b = r;}
+        period = period / a * loop;
+        if (period > MaxCycleWindow) return 0;
+    }
+    return uint(period);
+}
+
+/**
+ * @brief Keep the worms as they are now to check the tank repeats
+ */
+void WormTank::takeSnapshot()
+{
+    m_snapshot.resize(m_worms.size());
+    for (uint w = 0; w < m_worms.size(); w++)
+    {
+        const Worm *worm = m_worms[w];
+        WormSnapshot &snapshot = m_snapshot[w];
+        snapshot.body = worm->body();
+        snapshot.dir = worm->direction();
+        snapshot.energy = worm->energy();
+    }
+    m_snapshotTick = m_tick;
+}
+
+/**
+ * @brief Check if the tank is back as it was at the snapshot
+ *
+ * The food hasn't changed, so the tank is the same if every worm has
+ * the same body and direction. Worms that are still growing would be
+ * longer the next time round, so they have to be at full length.
+ *
+ * @return true if the tank will repeat itself while the worms use energy
+ */
+bool WormTank::repeatsSnapshot() const
+{
+    for (uint w = 0; w < m_worms.size(); w++)
+    {
+        const Worm *worm = m_worms[w];
+        const WormSnapshot &snapshot = m_snapshot[w];
+        const WormBody &body = worm->body();
+        if (worm->direction() != snapshot.dir || body.size() != worm->bodyLength()
+                || body.size() != snapshot.body.size()) return false;
+        for (uint j = 0; j < body.size(); j++)
+        {
+            if (body[j] != snapshot.body[j]) return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Skip the loops the tank goes round before anything changes
+ *
+ * Each worm uses the same energy every time round, so the number of
+ * times round is found that leaves every worm alive and the same
+ * length. The worms have that energy taken off and the tick moves on,
+ * leaving the tank exactly as a full run would have it.
+ */
+void WormTank::fastForward()
+{
+    uint loops = 0;
+    for (uint w = 0; w < m_worms.size(); w++)
+    {
+        // Every step uses energy so each time round uses some
+        const Worm *worm = m_worms[w];
+        uint used = m_snapshot[w].energy - worm->energy();
+        uint lowest = std::max(1u, worm->energy() / 100 * 100);
+        uint most = (worm->energy() - lowest) / used;
+        if (w == 0 || most < loops) loops = most;
+    }
+    if (loops == 0) return;
+
+    for (uint w = 0; w < m_worms.size(); w++)
+    {
+        Worm *worm = m_worms[w];
+        worm->useEnergy(loops * (m_snapshot[w].energy - worm->energy()));
+    }
+    m_tick += loops * m_loopPeriod;
+}
+
 /**
  * @brief start next generation
 */
 void WormTank::nextGeneration()
 {
+    m_moveCosts.endGeneration();
+    resetStagnation();
+
     // Sort survivors by energy
     std::sort(m_worms.begin(), m_worms.end(), more_energy);
 
@@ -985,28 +1512,90 @@ void WormTank::nextGeneration()
     emit lastGenerationTicksChanged(lastGenerationTicks());
     emit lastGenerationFoodLeftChanged(lastGenerationFoodLeft());
     emit lastGenerationMaxEnergyChanged(lastGenerationMaxEnergy());
+
+    m_lastGenerationAllocations = MemoryPool::allocations();
+    m_lastGenerationAllocatedBytes = MemoryPool::allocatedBytes();
+    MemoryPool::resetCounts();
+    emit lastGenerationAllocationsChanged(m_lastGenerationAllocations);
+    emit lastGenerationAllocatedBytesChanged(m_lastGenerationAllocatedBytes);
+    measureMemory();
 }
 
 /**
- * @brief Create a new generation of worms based on the top 10 survivors
+ * @brief Create a new generation of worms based on the top survivors
  */
 void WormTank::newGeneration()
 {
-    Worm *worm;
+    m_generationGenomes.clear();
+    for (auto worm : m_worms) m_generationGenomes.insert(worm->brainHash());
 
-    // Reset surviviors
-    for (int j = 0; j < 10; j++)
+    // Reset surviviors, the top ten get their own colours
+    uint numSurvivors = std::min<uint>(m_survivors, m_worms.size());
+    for (uint j = 0; j < numSurvivors; j++)
     {
         m_worms[j]->resetEnergy();
-        m_worms[j]->setColour(LEADER_COLOUR+j);
+        m_worms[j]->setColour(j < 10 ? LEADER_COLOUR+j : WORM_COLOUR);
         // Delete tail
         for (auto bodyIter = m_worms[j]->body().begin() + 1; bodyIter != m_worms[j]->body().end(); ++bodyIter)
         {
-            m_tankImage.setPixel(*bodyIter, GROUND_COLOUR);
+            setCell(*bodyIter, GROUND_COLOUR);
         }
         m_worms[j]->clearTail();
     }
 
+    // Breed rounds until the tank is back to its starting population
+    uint childrenLeft = m_startWorms > numSurvivors ? m_startWorms - numSurvivors : 0;
+    while (childrenLeft > 0 && numSurvivors > 0)
+    {
+        childrenLeft -= breedRound(numSurvivors, childrenLeft);
+    }
+
+    clearExcessFood();
+	moveFoodFromEdges();
+
+    // Bring food up to start level
+    while (m_food.size() < (unsigned)m_startFood)
+    {
+        QPoint foodPos = getEmptyPos();
+        m_food.push_back(foodPos);
+        setCell(foodPos, FOOD_COLOUR);
+    }
+
+    // Reward survivors so that children have to be better to replace them
+    int reward = numSurvivors * 10;
+    for (uint j = 0; j < numSurvivors; j++)
+    {
+        m_worms[j]->feed(reward);
+        reward -= 10;
+    }
+
+	// Start up next generation
+	m_generation++;
+	m_tick = 0;
+	emit generationChanged(m_generation);
+	emit tickChanged(m_tick);
+    setMaxEnergy(0);
+    setWormsLeft(m_worms.size());
+    setFoodLeft(m_food.size());
+    setGenomes(m_generationGenomes.size());
+}
+
+/**
+ * @brief Breed one round of children from the survivors
+ *
+ * With 10 survivors a round is 90 children: the leader gets 9 random
+ * variants and mates with each of the others, by average and by mix,
+ * then each of the others gets 7 random variants. Bigger populations
+ * run more rounds.
+ *
+ * @param numSurvivors number of survivors at the front of m_worms
+ * @param childrenLeft most children to add
+ * @return number of children added
+ */
+uint WormTank::breedRound(uint numSurvivors, uint childrenLeft)
+{
+    uint added = 0;
+
 	// leader gets most children
 	Worm *parent = m_worms[0];
     // 9 - Random variants
@@ -1014,77 +1603,199 @@ void WormTank::newGeneration()
 	{
         for (int weight = 5; weight <= 15; weight += 5)
         {
-            worm = parent->randomChild(chance, weight);
-            worm->resetPosition(getEmptyPos(), std::rand() & 3);
-            m_worms.push_back(worm);
-            m_tankImage.setPixel(worm->headPos(), WORM_COLOUR);
+            if (added == childrenLeft) return added;
+            addChild(parent->randomChild(chance, weight), chance, weight);
+            added++;
         }
 	}
-    // 9 mating with others in top ten using average
-    for (int j = 1; j < 10; j++)
+    // Mating with the other survivors using average
+    for (uint j = 1; j < numSurvivors; j++)
 	{
-        worm = parent->averageChild(m_worms[j], 20, 10);
-		worm->resetPosition(getEmptyPos(), std::rand() & 3);
-		m_worms.push_back(worm);
-        m_tankImage.setPixel(worm->headPos(), WORM_COLOUR);
+        if (added == childrenLeft) return added;
+        addChild(parent->averageChild(m_worms[j], 20, 10), 20, 10);
+        added++;
     }
 
-    // 9 mating with others in top ten using mix
-    for (int j = 1; j < 10; j++)
+    // Mating with the other survivors using mix
+    for (uint j = 1; j < numSurvivors; j++)
     {
-        worm = parent->mixChild(m_worms[j], 20, 10);
-        worm->resetPosition(getEmptyPos(), std::rand() & 3);
-        m_worms.push_back(worm);
-        m_tankImage.setPixel(worm->headPos(), WORM_COLOUR);
+        if (added == childrenLeft) return added;
+        addChild(parent->mixChild(m_worms[j], 20, 10), 20, 10);
+        added++;
     }
 
-    // 63 = 9 x (3 x 2 + 1) Random children based on the rest of the top ten
-	for (int k = 1; k < 10; k++)
+    // (3 x 2 + 1) Random children based on each of the other survivors
+	for (uint k = 1; k < numSurvivors; k++)
 	{
         parent = m_worms[k];
         for (int chance = 20; chance <= 60; chance+=20)
 		{
             for (int weight = 5; weight <= 15; weight += 10)
             {
-                worm = parent->randomChild(chance, weight);
-                worm->resetPosition(getEmptyPos(), std::rand() & 3);
-                m_worms.push_back(worm);
-                m_tankImage.setPixel(worm->headPos(), WORM_COLOUR);
+                if (added == childrenLeft) return added;
+                addChild(parent->randomChild(chance, weight), chance, weight);
+                added++;
             }
         }
-        worm = parent->randomChild(50, 20);
-        worm->resetPosition(getEmptyPos(), std::rand() & 3);
-        m_worms.push_back(worm);
-        m_tankImage.setPixel(worm->headPos(), WORM_COLOUR);
+        if (added == childrenLeft) return added;
+        addChild(parent->randomChild(50, 20), 50, 20);
+        added++;
     }
 
-    clearExcessFood();
-	moveFoodFromEdges();
+    return added;
+}
 
-    // Bring food up to start level
-    while (m_food.size() < (unsigned)m_startFood)
+/**
+ * @brief Add a child to the new generation
+ *
+ * A child with the same brain as a worm already in the generation is
+ * mutated again, a few times at most, so time isn't spent running the
+ * same brain twice.
+ *
+ * @param worm child to add
+ * @param chance percentage chance used to mutate a clone
+ * @param weight amount of change used to mutate a clone
+ */
+void WormTank::addChild(Worm *worm, int chance, int weight)
+{
+    for (int tries = 0; tries < MaxCloneMutations && !m_generationGenomes.insert(worm->brainHash()).second; tries++)
     {
-        QPoint foodPos = getEmptyPos();
-        m_food.push_back(foodPos);
-        m_tankImage.setPixel(foodPos, FOOD_COLOUR);
+        worm->mutate(chance, weight);
     }
+    worm->resetPosition(getEmptyPos(), std::rand() & 3);
+    m_worms.push_back(worm);
+    setCell(worm->headPos(), WORM_COLOUR);
+}
 
-    // Reward survivors so that children have to be better to replace them
-    int reward = m_survivors * 10;
-    for (uint j = 0; j < m_survivors; j++)
+/**
+ * @brief Get a worm with no brain or body to load or make a child into
+ *
+ * Worms that have been thrown away are used again so a long run of
+ * generations or league matches doesn't keep allocating them.
+ *
+ * @return worm to set up
+ */
+Worm *WormTank::newWorm()
+{
+    if (m_spareWorms.empty()) return new Worm(this);
+    Worm *worm = m_spareWorms.back();
+    m_spareWorms.pop_back();
+    return worm;
+}
+
+/**
+ * @brief Throw away a worm, keeping it to be used again by newWorm
+ * @param worm worm that is no longer in the tank
+ */
+void WormTank::recycleWorm(Worm *worm)
+{
+    worm->clearForReuse();
+    m_spareWorms.push_back(worm);
+}
+
+/**
+ * @brief Add up the memory used by each part of the tank
+ *
+ * Spare worms are included as they hold on to their bodies.
+ */
+void WormTank::measureMemory()
+{
+    m_memoryUsage.start();
+    m_memoryUsage.add(MemoryUsage::Grid, m_grid.memoryBytes());
+    m_memoryUsage.add(MemoryUsage::Food, MemoryUsage::vectorBytes(m_food));
+    m_memoryUsage.add(MemoryUsage::Worms, MemoryUsage::vectorBytes(m_worms)
+                      + MemoryUsage::vectorBytes(m_spareWorms) + MemoryUsage::vectorBytes(m_plannedMoves)
+                      + MemoryUsage::vectorBytes(m_cycleChecks) + MemoryUsage::vectorBytes(m_snapshot));
+    for (auto &snapshot : m_snapshot) m_memoryUsage.add(MemoryUsage::Worms, snapshot.body.capacity() * sizeof(QPoint));
+    m_memoryUsage.add(MemoryUsage::Brains, Brain::objectBytes());
+    for (auto worm : m_worms) worm->memoryUsage(m_memoryUsage);
+    for (auto worm : m_spareWorms) worm->memoryUsage(m_memoryUsage);
+
+    // Genomes set estimated as a node for each hash and a pointer for each bucket
+    size_t genomesBytes = m_generationGenomes.size() * (sizeof(quint64) + 2 * sizeof(void *))
+                          + m_generationGenomes.bucket_count() * sizeof(void *);
+    size_t scratchBytes = MemoryUsage::vectorBytes(m_scratch.pointsInRange);
+    for (auto &scratch : m_plannerScratch) scratchBytes += MemoryUsage::vectorBytes(scratch.pointsInRange);
+    m_memoryUsage.add(MemoryUsage::Indexes, m_foodIndex.memoryBytes() + m_wormIndex.memoryBytes()
+                      + m_foodDistance.memoryBytes() + genomesBytes + m_tiles.memoryBytes() + scratchBytes);
+    m_memoryUsage.add(MemoryUsage::History, MemoryUsage::vectorBytes(m_history.items()));
+    m_memoryUsage.add(MemoryUsage::MoveCosts, m_moveCosts.memoryBytes());
+    m_memoryUsage.finish();
+}
+
+/**
+ * @brief Plan the moves of all the worms, a tile at a time on several threads
+ *
+ * Nothing in the tank changes while the moves are planned, so the
+ * worms sense the tank as it was at the start of the tick and there is
+ * no need to lock the grid. The moves are then made in the order of
+ * the worm list, which makes the results the same whatever the tile
+ * layout or the number of threads.
+ */
+void WormTank::planMovesInTiles()
+{
+    m_tiles.assignWorms(m_worms);
+    m_plannedMoves.resize(m_worms.size());
+
+    uint numTiles = m_tiles.numTiles();
+    uint numPlanners = std::min<uint>(std::max(1, QThread::idealThreadCount()), numTiles);
+    if (m_plannerScratch.size() < numPlanners) m_plannerScratch.resize(numPlanners);
+
+    std::atomic<uint> nextTile(0);
+    if (numPlanners == 1)
     {
-        m_worms[j]->feed(reward);
-        reward -= 10;
+        TilePlanner(this, &m_plannerScratch[0], &nextTile, numTiles).run();
+        return;
+    }
+    for (uint j = 0; j < numPlanners; j++)
+    {
+        m_plannerPool.start(new TilePlanner(this, &m_plannerScratch[j], &nextTile, numTiles));
     }
+    m_plannerPool.waitForDone();
+}
 
-	// Start up next generation
-	m_generation++;
-	m_tick = 0;
-	emit generationChanged(m_generation);
-	emit tickChanged(m_tick);
-    setMaxEnergy(0);
-    setWormsLeft(m_worms.size());
-    setFoodLeft(m_food.size());
+/**
+ * @brief Plan the moves of the worms in one tile
+ *
+ * Called on a planning thread, so only changes the worms in the tile
+ * and their planned moves.
+ *
+ * @param tile tile to plan
+ */
+void WormTank::planTileMoves(uint tile)
+{
+    for (uint w : m_tiles.tileWorms(tile))
+    {
+        PlannedMove &move = m_plannedMoves[w];
+        m_worms[w]->planMove(move.pt, move.dir, move.nsecs);
+    }
+}
+
+/**
+ * @brief Take the food eaten so far this step out of m_food
+ *
+ * Eaten food is no longer on a food cell. Removing it all in one pass,
+ * keeping the order, saves searching the whole list each time a worm
+ * eats in a big tank.
+ */
+void WormTank::removeEatenFood()
+{
+    if (m_foodEaten == 0) return;
+    m_food.erase(std::remove_if(m_food.begin(), m_food.end(),
+                                [this](QPoint foodPos) {return cellAt(cellIndex(foodPos)) != FOOD_COLOUR;}),
+                 m_food.end());
+    m_foodEaten = 0;
+}
+
+/**
+ * @brief Count the different brains in the tank
+ * @return number of different brains
+ */
+uint WormTank::countGenomes() const
+{
+    std::unordered_set<quint64> genomes;
+    for (auto worm : m_worms) genomes.insert(worm->brainHash());
+    return genomes.size();
 }
 
 /**
@@ -1128,10 +1839,9 @@ void WormTank::endOfLeagueGeneration()
             Worm *worm = m_worms[j];
             if (worm->colour() >= TEAM1_COLOUR + CHILD_OFFSET) worm->setColour(worm->colour()-CHILD_OFFSET);
             Worm *child = worm->randomChild(20, 5);
-            child->clearTail();
             child->resetPosition(getEmptyPos(), std::rand() & 3);
             m_worms.push_back(child);
-            m_tankImage.setPixel(child->headPos(), worm->colour());
+            setCell(child->headPos(), worm->colour());
         }
 
         m_generation++;
@@ -1207,7 +1917,7 @@ QPoint WormTank::getEmptyPos()
 	{
 		x = randBetween(10, m_width - 10);
 		y = randBetween(10, m_height - 10);
-	} while (m_tankImage.pixelIndex(x, y));
+	} while (cellAt(cellIndex(QPoint(x, y))));
 
 	return QPoint(x, y);
 }
@@ -1219,29 +1929,20 @@ QPoint WormTank::getEmptyPos()
  *
  * @param pt Worm head position
  * @param dir direction worm is facing
- * @param inputs 4 InputBrainCell array for left, ahead, right and nothing seen
+ * @param inputs 4 input array for left, ahead, right and nothing seen
  */
-void WormTank::foodSeen(QPoint pt, int dir, InputBrainCell *inputs)
+void WormTank::foodSeen(QPoint pt, int dir, int *inputs)
 {
-    for (int j = 0; j < 4; j++) inputs[j].setValue(0);
     int left = (dir + 3) % 4;
     int ahead = dir;
     int right = (dir + 1) % 4;
 
-	for (auto foodPt : m_food)
-	{
-		int xDiff = foodPt.x() - pt.x();
-		int yDiff = foodPt.y() - pt.y();
-        if (xDiff != 0 && yDiff != 0)
-        {
-            int foodDir = direction(xDiff, yDiff);
-            if (foodDir == left) inputs[0].setValue(1);
-            else if (foodDir == ahead) inputs[1].setValue(1);
-            else if (foodDir == right) inputs[2].setValue(1);
-        }
-	}
+    inputs[0] = m_foodIndex.anyInCone(pt, left);
+    inputs[1] = m_foodIndex.anyInCone(pt, ahead);
+    inputs[2] = m_foodIndex.anyInCone(pt, right);
+
     // Set nothing seens if no inputs
-    inputs[3].setValue(!(inputs[0].value() | inputs[1].value() | inputs[2].value()));
+    inputs[3] = !(inputs[0] | inputs[1] | inputs[2]);
 }
 
 /**
@@ -1251,32 +1952,20 @@ void WormTank::foodSeen(QPoint pt, int dir, InputBrainCell *inputs)
  *
  * @param pt Worm head position
  * @param dir direction worm is facing
- * @param inputs 4 InputBrainCell array for left, ahead, right and nothing seen
+ * @param inputs 4 input array for left, ahead, right and nothing seen
  */
-void WormTank::wormSeen(QPoint pt, int dir, InputBrainCell *inputs)
+void WormTank::wormSeen(QPoint pt, int dir, int *inputs)
 {
-    for (int j = 0; j < 4; j++) inputs[j].setValue(0);
     int left = (dir + 3) % 4;
     int ahead = dir;
     int right = (dir + 1) % 4;
 
-    for (auto worm : m_worms)
-    {
-        for (auto wormPt : worm->body())
-        {
-            int xDiff = wormPt.x() - pt.x();
-            int yDiff = wormPt.y() - pt.y();
-            if (xDiff != 0 && yDiff != 0)
-            {
-                int wormDir = direction(xDiff, yDiff);
-                if (wormDir == left) inputs[0].setValue(1);
-                else if (wormDir == ahead) inputs[1].setValue(1);
-                else if (wormDir == right) inputs[2].setValue(1);
-            }
-        }
-    }
+    inputs[0] = m_wormIndex.anyInCone(pt, left);
+    inputs[1] = m_wormIndex.anyInCone(pt, ahead);
+    inputs[2] = m_wormIndex.anyInCone(pt, right);
+
     // Set nothing seens if no inputs
-    inputs[3].setValue(!(inputs[0].value() | inputs[1].value() | inputs[2].value()));
+    inputs[3] = !(inputs[0] | inputs[1] | inputs[2]);
 }
 
 
@@ -1287,36 +1976,15 @@ void WormTank::wormSeen(QPoint pt, int dir, InputBrainCell *inputs)
  *
  * @param pt Worm head position
  * @param dir direction worm is facing
- * @param inputs 4 InputBrainCell array for left, ahead, right and nothing seen
+ * @param inputs 4 input array for left, ahead, right and nothing seen
  */
-void WormTank::foodNextTo(QPoint pt, int dir, InputBrainCell *inputs)
+void WormTank::foodNextTo(QPoint pt, int dir, int *inputs)
 {
-    for (int j = 0; j < 4; j++) inputs[j].setValue(0);
-
-    int left = (dir + 3) % 4;
-    int ahead = dir;
-    int right = (dir + 1) % 4;
-    QPoint check(pt);
-    movePoint(pt, left);
-    if (pointInTank(pt) && m_tankImage.pixelIndex(pt) == FOOD_COLOUR)
-    {
-        inputs[0].setValue(1);
-    }
-    check = pt;
-    movePoint(pt, ahead);
-    if (pointInTank(pt) && m_tankImage.pixelIndex(pt) == FOOD_COLOUR)
-    {
-        inputs[1].setValue(1);
-    }
-    check = pt;
-    movePoint(pt, right);
-    if (pointInTank(pt) && m_tankImage.pixelIndex(pt) == FOOD_COLOUR)
-    {
-        inputs[2].setValue(1);
-    }
+    const int *cells = nextToCells(pt, dir);
+    for (int j = 0; j < 3; j++) inputs[j] = (cells[j] == FOOD_COLOUR);
 
     // Set nothing seens if no inputs
-    inputs[3].setValue(!(inputs[0].value() | inputs[1].value() | inputs[2].value()));
+    inputs[3] = !(inputs[0] | inputs[1] | inputs[2]);
 }
 
 /**
@@ -1326,36 +1994,15 @@ void WormTank::foodNextTo(QPoint pt, int dir, InputBrainCell *inputs)
  *
  * @param pt Worm head position
  * @param dir direction worm is facing
- * @param inputs 4 InputBrainCell array for left, ahead, right and nothing seen
+ * @param inputs 4 input array for left, ahead, right and nothing seen
  */
-void WormTank::wormNextTo(QPoint pt, int dir, InputBrainCell *inputs)
+void WormTank::wormNextTo(QPoint pt, int dir, int *inputs)
 {
-    for (int j = 0; j < 4; j++) inputs[j].setValue(0);
-
-    int left = (dir + 3) % 4;
-    int ahead = dir;
-    int right = (dir + 1) % 4;
-    QPoint check(pt);
-    movePoint(pt, left);
-    if (pointInTank(pt) && m_tankImage.pixelIndex(pt) >= WORM_COLOUR)
-    {
-        inputs[0].setValue(1);
-    }
-    check = pt;
-    movePoint(pt, ahead);
-    if (pointInTank(pt) && m_tankImage.pixelIndex(pt) >= WORM_COLOUR)
-    {
-        inputs[1].setValue(1);
-    }
-    check = pt;
-    movePoint(pt, right);
-    if (pointInTank(pt) && m_tankImage.pixelIndex(pt) >= WORM_COLOUR)
-    {
-        inputs[2].setValue(1);
-    }
+    const int *cells = nextToCells(pt, dir);
+    for (int j = 0; j < 3; j++) inputs[j] = (cells[j] >= WORM_COLOUR);
 
     // Set nothing seen if no inputs
-    inputs[3].setValue(!(inputs[0].value() | inputs[1].value() | inputs[2].value()));
+    inputs[3] = !(inputs[0] | inputs[1] | inputs[2]);
 }
 
 /**
@@ -1365,9 +2012,9 @@ void WormTank::wormNextTo(QPoint pt, int dir, InputBrainCell *inputs)
  *
  * @param pt Worm head position
  * @param dir direction worm is facing
- * @param inputs 4 InputBrainCell array for left, ahead, right and nothing seen
+ * @param inputs 4 input array for left, ahead, right and nothing seen
  */
-void WormTank::wallNextTo(QPoint pt, int dir, InputBrainCell *inputs)
+void WormTank::wallNextTo(QPoint pt, int dir, int *inputs)
 {
     int wall[4];
     wall[0] = (pt.y() == m_height - 1);
@@ -1379,14 +2026,85 @@ void WormTank::wallNextTo(QPoint pt, int dir, InputBrainCell *inputs)
     int ahead = dir;
     int right = (dir + 1) % 4;
 
-    inputs[0].setValue(wall[left]);
-    inputs[1].setValue(wall[ahead]);
-    inputs[2].setValue(wall[right]);
+    inputs[0] = wall[left];
+    inputs[1] = wall[ahead];
+    inputs[2] = wall[right];
 
     // Set nothing seen if no inputs
-    inputs[3].setValue(!(inputs[0].value() | inputs[1].value() | inputs[2].value()));
+    inputs[3] = !(inputs[0] | inputs[1] | inputs[2]);
+}
+
+
+/**
+ * @brief Set up the ranges and inputs for a range sensor
+ * @param ranges pointer to the first range
+ * @param numRanges number of ranges
+ * @param rangesSquared set to the squares of the ranges
+ * @param inputs 4 * number of ranges inputs, set to 0
+ * @return square of the largest range
+ */
+int WormTank::setupRanges(const int *ranges, int numRanges, int *rangesSquared, int *inputs) const
+{
+    int maxRangeSquared = -1;
+    for (int j = 0; j < numRanges; j++)
+    {
+        rangesSquared[j] = ranges[j] * ranges[j];
+        maxRangeSquared = std::max(maxRangeSquared, rangesSquared[j]);
+    }
+    for (int j = 0; j < numRanges * 4; j++) inputs[j] = 0;
+    return maxRangeSquared;
 }
 
+/**
+ * @brief Get the food a range sensor could see
+ *
+ * Only the food within the largest range can be in any of the ranges,
+ * so it is found from the index unless the range covers the whole tank.
+ *
+ * @param pt Worm head position
+ * @param maxRangeSquared square of the largest range
+ * @return food positions, in no particular order
+ */
+const std::vector<QPoint> &WormTank::foodInRange(QPoint pt, int maxRangeSquared)
+{
+    if (maxRangeSquared >= int(m_maxDistance * m_maxDistance))
+    {
+        removeEatenFood();
+        return m_food;
+    }
+    std::vector<QPoint> &found = sensorScratch().pointsInRange;
+    m_foodIndex.within(pt, maxRangeSquared, found);
+    return found;
+}
+
+/**
+ * @brief Get the worm body cells a range sensor could see
+ * @param pt Worm head position
+ * @param maxRangeSquared square of the largest range
+ * @return body cells, in no particular order
+ */
+const std::vector<QPoint> &WormTank::wormsInRange(QPoint pt, int maxRangeSquared)
+{
+    std::vector<QPoint> &found = sensorScratch().pointsInRange;
+    if (maxRangeSquared < int(m_maxDistance * m_maxDistance))
+    {
+        m_wormIndex.within(pt, maxRangeSquared, found);
+        return found;
+    }
+
+    // Copying the bodies is quicker than going through the whole index
+    found.clear();
+    for (auto worm : m_worms)
+    {
+        BodySpan spans[2];
+        uint numSpans = worm->body().spans(spans);
+        for (uint s = 0; s < numSpans; s++)
+        {
+            found.insert(found.end(), spans[s].cells, spans[s].cells + spans[s].count);
+        }
+    }
+    return found;
+}
 
 /**
 * @brief Set the input to 1 for the ranges given
@@ -1396,7 +2114,7 @@ void WormTank::wallNextTo(QPoint pt, int dir, InputBrainCell *inputs)
 * @param numRanges number of ranges to check
 * @param inputs inputs to update
 */
-void WormTank::setFoundRanges(QPoint ptRelative, int dir, int *rangesSquared, int numRanges, InputBrainCell *inputs)
+void WormTank::setFoundRanges(QPoint ptRelative, int dir, int *rangesSquared, int numRanges, int *inputs)
 {
 	int xDiff = ptRelative.x();
 	int yDiff = ptRelative.y();
@@ -1413,14 +2131,14 @@ void WormTank::setFoundRanges(QPoint ptRelative, int dir, int *rangesSquared, in
 			while (j < numRanges && distSquared > rangesSquared[j]) j++;
 			if (j < numRanges)
 			{
-                InputBrainCell *setInputs = inputs + 4 * j;
+                int *setInputs = inputs + 4 * j;
 				int left = (dir + 3) % 4;
 				int ahead = dir;
 				int right = (dir + 1) % 4;
 
-				if (ptDir == left) setInputs[0].setValue(1);
-				else if (ptDir == ahead) setInputs[1].setValue(1);
-				else if (ptDir == right) setInputs[2].setValue(1);
+				if (ptDir == left) setInputs[0] = 1;
+				else if (ptDir == ahead) setInputs[1] = 1;
+				else if (ptDir == right) setInputs[2] = 1;
 			}
 		}
 	}
@@ -1431,11 +2149,11 @@ void WormTank::setFoundRanges(QPoint ptRelative, int dir, int *rangesSquared, in
  *
  * Call after setting the ahead, left and right inputs for the tnages
  */
-void WormTank::setNotFoundRanges(int numRanges, InputBrainCell *inputs)
+void WormTank::setNotFoundRanges(int numRanges, int *inputs)
 {
 	for (int j = 0; j < numRanges; j++)
 	{
-		inputs[3].setValue(inputs[0].value() == 0 && inputs[1].value() == 0 && inputs[2].value() == 0);
+		inputs[3] = (inputs[0] == 0 && inputs[1] == 0 && inputs[2] == 0);
 		inputs += 4;
 	}
 }
@@ -1448,7 +2166,7 @@ void WormTank::setNotFoundRanges(int numRanges, InputBrainCell *inputs)
 * @param numRanges number of ranges to check
 * @param inputs inputs to update
 */
-void WormTank::countFoundRanges(QPoint ptRelative, int dir, int *rangesSquared, int numRanges, InputBrainCell *inputs)
+void WormTank::countFoundRanges(QPoint ptRelative, int dir, int *rangesSquared, int numRanges, int *inputs)
 {
 	int xDiff = ptRelative.x();
 	int yDiff = ptRelative.y();
@@ -1465,14 +2183,14 @@ void WormTank::countFoundRanges(QPoint ptRelative, int dir, int *rangesSquared,
 			while (j < numRanges && distSquared > rangesSquared[j]) j++;
 			if (j < numRanges)
 			{
-                InputBrainCell *setInputs = inputs + 4 * j;
+                int *setInputs = inputs + 4 * j;
 				int left = (dir + 3) % 4;
 				int ahead = dir;
 				int right = (dir + 1) % 4;
 
-				if (ptDir == left) setInputs[0].setValue(setInputs[0].value()+1);
-                else if (ptDir == ahead) setInputs[1].setValue(setInputs[1].value()+1);
-                else if (ptDir == right) setInputs[2].setValue(setInputs[2].value()+1);
+				if (ptDir == left) setInputs[0]++;
+                else if (ptDir == ahead) setInputs[1]++;
+                else if (ptDir == right) setInputs[2]++;
 			}
 		}
 	}
@@ -1488,16 +2206,14 @@ void WormTank::countFoundRanges(QPoint ptRelative, int dir, int *rangesSquared,
  * @param dir direction worm is facing
  * @param ranges pointer to the first range
  * @param numRanges number of ranges
- * @param inputs 4 * number of ranges InputBrainCell array for left, ahead, right and nothing seen
+ * @param inputs 4 * number of ranges input array for left, ahead, right and nothing seen
  */
-void WormTank::foodSeen(QPoint pt, int dir, int *ranges, int numRanges , InputBrainCell *inputs)
+void WormTank::foodSeen(QPoint pt, int dir, const int *ranges, int numRanges , int *inputs)
 {
 	int rangesSquared[numRanges];
-	int j;
 
-	for (j = 0; j < numRanges; j++) rangesSquared[j] = ranges[j] * ranges[j];
-	for (j = 0; j < numRanges * 4; j++) inputs[j].setValue(0);
-	for (auto foodPos : m_food)
+	int maxRangeSquared = setupRanges(ranges, numRanges, rangesSquared, inputs);
+	for (auto foodPos : foodInRange(pt, maxRangeSquared))
 	{
 		foodPos -= pt; // Make point relative to worm head
 		setFoundRanges(foodPos, dir, rangesSquared, numRanges, inputs);
@@ -1515,22 +2231,17 @@ void WormTank::foodSeen(QPoint pt, int dir, int *ranges, int numRanges , InputBr
 * @param dir direction worm is facing
 * @param ranges pointer to the first range
 * @param numRanges number of ranges
-* @param inputs 4 * number of ranges InputBrainCell array for left, ahead, right and nothing seen
+* @param inputs 4 * number of ranges input array for left, ahead, right and nothing seen
 */
-void WormTank::wormSeen(QPoint pt, int dir, int *ranges, int numRanges, InputBrainCell *inputs)
+void WormTank::wormSeen(QPoint pt, int dir, const int *ranges, int numRanges, int *inputs)
 {
 	int rangesSquared[numRanges];
-	int j;
 
-	for (j = 0; j < numRanges; j++) rangesSquared[j] = ranges[j] * ranges[j];
-	for (j = 0; j < numRanges * 4; j++) inputs[j].setValue(0);
-	for (auto worm : m_worms)
+	int maxRangeSquared = setupRanges(ranges, numRanges, rangesSquared, inputs);
+	for (auto bodyPos : wormsInRange(pt, maxRangeSquared))
 	{
-		for (auto bodyPos : worm->body())
-		{
-			bodyPos -= pt; // Make relative to observing worm head
-			setFoundRanges(bodyPos, dir, rangesSquared, numRanges, inputs);
-		}
+		bodyPos -= pt; // Make relative to observing worm head
+		setFoundRanges(bodyPos, dir, rangesSquared, numRanges, inputs);
 	}
 	setNotFoundRanges(numRanges, inputs);
 }
@@ -1546,15 +2257,15 @@ void WormTank::wormSeen(QPoint pt, int dir, int *ranges, int numRanges, InputBra
 * @param dir direction worm is facing
 * @param ranges pointer to the first range
 * @param numRanges number of ranges
-* @param inputs 4 * number of ranges InputBrainCell array for left, ahead, right and nothing seen
+* @param inputs 4 * number of ranges input array for left, ahead, right and nothing seen
 */
-void WormTank::wallSeen(QPoint pt, int dir, int *ranges, int numRanges, InputBrainCell *inputs)
+void WormTank::wallSeen(QPoint pt, int dir, const int *ranges, int numRanges, int *inputs)
 {
 	int rangesSquared[numRanges];
 	int j;
 
 	for (j = 0; j < numRanges; j++) rangesSquared[j] = ranges[j] * ranges[j];
-	for (j = 0; j < numRanges * 4; j++) inputs[j].setValue(0);
+	for (j = 0; j < numRanges * 4; j++) inputs[j] = 0;
 
 	QPoint westWall(-1, pt.y());
 	QPoint eastWall(m_width, pt.y());
@@ -1585,16 +2296,14 @@ void WormTank::wallSeen(QPoint pt, int dir, int *ranges, int numRanges, InputBra
 * @param dir direction worm is facing
 * @param ranges pointer to the first range
 * @param numRanges number of ranges
-* @param inputs 4 * number of ranges InputBrainCell array for left, ahead, right and nothing seen
+* @param inputs 4 * number of ranges input array for left, ahead, right and nothing seen
 */
-void WormTank::foodCount(QPoint pt, int dir, int *ranges, int numRanges, InputBrainCell *inputs)
+void WormTank::foodCount(QPoint pt, int dir, const int *ranges, int numRanges, int *inputs)
 {
 	int rangesSquared[numRanges];
-	int j;
 
-	for (j = 0; j < numRanges; j++) rangesSquared[j] = ranges[j] * ranges[j];
-	for (j = 0; j < numRanges * 4; j++) inputs[j].setValue(0);
-	for (auto foodPos : m_food)
+	int maxRangeSquared = setupRanges(ranges, numRanges, rangesSquared, inputs);
+	for (auto foodPos : foodInRange(pt, maxRangeSquared))
 	{
 		foodPos -= pt; // Make point relative to worm head
 		countFoundRanges(foodPos, dir, rangesSquared, numRanges, inputs);
@@ -1612,22 +2321,17 @@ void WormTank::foodCount(QPoint pt, int dir, int *ranges, int numRanges, InputBr
 * @param dir direction worm is facing
 * @param ranges pointer to the first range
 * @param numRanges number of ranges
-* @param inputs 4 * number of ranges InputBrainCell array for left, ahead, right and nothing seen
+* @param inputs 4 * number of ranges input array for left, ahead, right and nothing seen
 */
-void WormTank::wormCount(QPoint pt, int dir, int *ranges, int numRanges, InputBrainCell *inputs)
+void WormTank::wormCount(QPoint pt, int dir, const int *ranges, int numRanges, int *inputs)
 {
 	int rangesSquared[numRanges];
-	int j;
 
-	for (j = 0; j < numRanges; j++) rangesSquared[j] = ranges[j] * ranges[j];
-	for (j = 0; j < numRanges * 4; j++) inputs[j].setValue(0);
-	for (auto worm : m_worms)
+	int maxRangeSquared = setupRanges(ranges, numRanges, rangesSquared, inputs);
+	for (auto bodyPos : wormsInRange(pt, maxRangeSquared))
 	{
-		for (auto bodyPos : worm->body())
-		{
-			bodyPos -= pt; // Make relative to observing worm head
-			countFoundRanges(bodyPos, dir, rangesSquared, numRanges, inputs);
-		}
+		bodyPos -= pt; // Make relative to observing worm head
+		countFoundRanges(bodyPos, dir, rangesSquared, numRanges, inputs);
 	}
 	setNotFoundRanges(numRanges, inputs);
 }
@@ -1637,14 +2341,14 @@ void WormTank::wormCount(QPoint pt, int dir, int *ranges, int numRanges, InputBr
  * on if the first thing hit is food or not
  * @param pt Worm head position
  * @param dir direction worm is facing
- * @param inputs 4 InputBrainCell array for left, ahead, right and no food hit
+ * @param inputs 4 input array for left, ahead, right and no food hit
  */
-void WormTank::foodBeam(QPoint pt, int dir, InputBrainCell *inputs)
+void WormTank::foodBeam(QPoint pt, int dir, int *inputs)
 {
-    inputs[0].setValue(beam(pt, (dir + 3) % 4) == FOOD_COLOUR);
-    inputs[1].setValue(beam(pt, dir) == FOOD_COLOUR);
-    inputs[2].setValue(beam(pt, (dir + 1) % 4) == FOOD_COLOUR);
-    inputs[3].setValue(!(inputs[0].value() | inputs[1].value() | inputs[2].value()));
+    inputs[0] = (beam(pt, (dir + 3) % 4) == FOOD_COLOUR);
+    inputs[1] = (beam(pt, dir) == FOOD_COLOUR);
+    inputs[2] = (beam(pt, (dir + 1) % 4) == FOOD_COLOUR);
+    inputs[3] = !(inputs[0] | inputs[1] | inputs[2]);
 }
 
 /**
@@ -1652,17 +2356,17 @@ void WormTank::foodBeam(QPoint pt, int dir, InputBrainCell *inputs)
  * on if the first thing hit is a worm or not
  * @param pt Worm head position
  * @param dir direction worm is facing
- * @param inputs 4 InputBrainCell array for left, ahead, right and no worm hit
+ * @param inputs 4 input array for left, ahead, right and no worm hit
  */
-void WormTank::wormBeam(QPoint pt, int dir, InputBrainCell *inputs)
+void WormTank::wormBeam(QPoint pt, int dir, int *inputs)
 {
     int hit = beam(pt, (dir + 3) % 4);
-    inputs[0].setValue( hit != FOOD_COLOUR && hit != GROUND_COLOUR );
+    inputs[0] = (hit != FOOD_COLOUR && hit != GROUND_COLOUR);
     hit = beam(pt, dir);
-    inputs[1].setValue( hit != FOOD_COLOUR && hit != GROUND_COLOUR );
+    inputs[1] = (hit != FOOD_COLOUR && hit != GROUND_COLOUR);
     hit = beam(pt, (dir + 1) % 4);
-    inputs[2].setValue( hit != FOOD_COLOUR && hit != GROUND_COLOUR );
-    inputs[3].setValue(!(inputs[0].value() | inputs[1].value() | inputs[2].value()));
+    inputs[2] = (hit != FOOD_COLOUR && hit != GROUND_COLOUR);
+    inputs[3] = !(inputs[0] | inputs[1] | inputs[2]);
 }
 
 /**
@@ -1670,67 +2374,131 @@ void WormTank::wormBeam(QPoint pt, int dir, InputBrainCell *inputs)
  * on if the first thing hit is wall or not
  * @param pt Worm head position
  * @param dir direction worm is facing
- * @param inputs 4 InputBrainCell array for left, ahead, right and no wall hit
+ * @param inputs 4 input array for left, ahead, right and no wall hit
  */
-void WormTank::wallBeam(QPoint pt, int dir, InputBrainCell *inputs)
+void WormTank::wallBeam(QPoint pt, int dir, int *inputs)
 {
-    inputs[0].setValue(beam(pt, (dir + 3) % 4) == GROUND_COLOUR);
-    inputs[1].setValue(beam(pt, dir) == GROUND_COLOUR);
-    inputs[2].setValue(beam(pt, (dir + 1) % 4) == GROUND_COLOUR);
-    inputs[3].setValue(!(inputs[0].value() | inputs[1].value() | inputs[2].value()));
+    inputs[0] = (beam(pt, (dir + 3) % 4) == GROUND_COLOUR);
+    inputs[1] = (beam(pt, dir) == GROUND_COLOUR);
+    inputs[2] = (beam(pt, (dir + 1) % 4) == GROUND_COLOUR);
+    inputs[3] = !(inputs[0] | inputs[1] | inputs[2]);
 }
 
 /**
- * @brief Return first thing hit in straight line from pt in given direction.
- * @param pt worm head position
- * @param dir direction to send beam
- * @return COLOUR of first thing hits or GROUND_COLOUR for the wall
+ * @brief Set inputs from the nearest points in the left, ahead and right cones
+ *
+ * Each input is set to the maximum distance less the distance to the
+ * nearest point in that direction, so nearer points give larger values,
+ * or 0 if there are none.
+ *
+ * @param index spatial index to search
+ * @param pt Worm head position
+ * @param dir direction worm is facing
+ * @param inputs 4 input array for left, ahead, right and nothing found
  */
-int WormTank::beam(QPoint pt, int dir) const
+void WormTank::nearestInCones(const QuadTree &index, QPoint pt, int dir, int *inputs)
 {
-    int hit = GROUND_COLOUR;
-    int x = pt.x();
-    int y = pt.y();
-
-    switch(dir)
+    int coneDir[3] = {(dir + 3) % 4, dir, (dir + 1) % 4};
+    bool anyFound = false;
+    for (int j = 0; j < 3; j++)
     {
-    case 0: // North
-        while (y < m_height-1 && hit == GROUND_COLOUR)
+        QPoint found;
+        int distSquared;
+        if (index.nearest(pt, coneDir[j], found, distSquared))
         {
-            y++;
-            hit = *(m_tankImage.constScanLine(y) + x);
-        }
-        break;
-    case 1: // East
+            inputs[j] = int(m_maxDistance) - int(std::sqrt(double(distSquared)));
+            anyFound = true;
+        } else
         {
-            auto line = m_tankImage.constScanLine(y);
-            while (x < m_width -1 && hit == GROUND_COLOUR)
-            {
-                x++;
-                hit = *(line + x);
-            }
+            inputs[j] = 0;
         }
-        break;
-    case 2: // South
-        while (y > 0 && hit == GROUND_COLOUR)
-        {
-            y--;
-            hit = *(m_tankImage.constScanLine(y) + x);
-        }
-        break;
-    case 3: // West
+    }
+    inputs[3] = !anyFound;
+}
+
+/**
+ * @brief Fill in the inputs with the nearest food sensor
+ *
+ * Gives the distance to the nearest food to the left, ahead and right
+ *
+ * @param pt Worm head position
+ * @param dir direction worm is facing
+ * @param inputs 4 input array for left, ahead, right and nothing found
+ */
+void WormTank::foodNearest(QPoint pt, int dir, int *inputs)
+{
+    nearestInCones(m_foodIndex, pt, dir, inputs);
+}
+
+/**
+ * @brief Fill in the inputs with the nearest worm sensor
+ *
+ * Gives the distance to the nearest worm to the left, ahead and right
+ *
+ * @param pt Worm head position
+ * @param dir direction worm is facing
+ * @param inputs 4 input array for left, ahead, right and nothing found
+ */
+void WormTank::wormNearest(QPoint pt, int dir, int *inputs)
+{
+    nearestInCones(m_wormIndex, pt, dir, inputs);
+}
+
+/**
+ * @brief Fill in the inputs with the food gradient sensor
+ *
+ * This sensor detects which of the cells to the left, ahead and right
+ * is the fewest moves from food, going round worms and walls. All the
+ * cells that are equally close are set.
+ *
+ * @param pt Worm head position
+ * @param dir direction worm is facing
+ * @param inputs 4 input array for left, ahead, right and no food reachable
+ */
+void WormTank::foodGradient(QPoint pt, int dir, int *inputs)
+{
+    // Only pay for the field and keeping it up to date once a worm uses
+    // it, which may be on any of the threads planning moves
+    if (!m_foodDistance.active())
+    {
+        QMutexLocker lock(&m_foodDistanceMutex);
+        if (!m_foodDistance.active())
         {
-            auto line = m_tankImage.constScanLine(y);
-            while (x > 0 && hit == GROUND_COLOUR)
-            {
-                x--;
-                hit = *(line + x);
-            }
+            m_foodDistance.allocate();
+            m_grid.forEachCell([this](QPoint cell, int colour) {m_foodDistance.setState(cell, distanceState(colour));});
+            m_foodDistance.rebuild();
         }
-        break;
     }
 
-    return hit;
+    int moveDir[3] = {(dir + 3) % 4, dir, (dir + 1) % 4};
+    int distance[3];
+    int nearest = DistanceField::Unreachable;
+    for (int j = 0; j < 3; j++)
+    {
+        QPoint next(pt);
+        movePoint(next, moveDir[j]);
+        distance[j] = m_foodDistance.distance(next);
+        if (distance[j] < nearest) nearest = distance[j];
+    }
+    for (int j = 0; j < 3; j++)
+    {
+        inputs[j] = (nearest != DistanceField::Unreachable && distance[j] == nearest);
+    }
+    inputs[3] = (nearest == DistanceField::Unreachable);
+}
+
+/**
+ * @brief Return first thing hit in straight line from pt in given direction.
+ * @param pt worm head position
+ * @param dir direction to send beam
+ * @return COLOUR of first thing hits or GROUND_COLOUR for the wall
+ */
+int WormTank::beam(QPoint pt, int dir) const
+{
+    // Number of cells between the head and the edge in each direction
+    int cellsToEdge[4] = {m_height - 1 - pt.y(), m_width - 1 - pt.x(), pt.y(), pt.x()};
+
+    return m_grid.firstInLine(pt, dir, cellsToEdge[dir]);
 }
 
 
@@ -1758,7 +2526,8 @@ QImage WormTankImageProvider::requestImage(const QString & id, QSize * size, con
     QImage result;
 
     if (requestedSize.isValid()) {
-       result = m_wormTank.tankImage().scaled(requestedSize, Qt::KeepAspectRatio);
+       QSize tankSize(m_wormTank.width(), m_wormTank.height());
+       result = m_wormTank.tankImage(tankSize.scaled(requestedSize, Qt::KeepAspectRatio));
     } else {
        result = m_wormTank.tankImage();
     }
@@ -3,12 +3,21 @@
 
 #include <QObject>
 #include <QImage>
+#include <QMutex>
+#include <QThreadPool>
 #include <vector>
 #include <string>
+#include <unordered_set>
 #include "QQuickImageProvider"
 #include "worm.h"
-#include "braincell.h"
 #include "history.h"
+#include "quadtree.h"
+#include "distancefield.h"
+#include "movecost.h"
+#include "memoryusage.h"
+#include "tanksettings.h"
+#include "tanktiles.h"
+#include "tankgrid.h"
 
 class League;
 
@@ -29,13 +38,35 @@ class WormTank : public QObject
     Q_PROPERTY(uint lastGenerationTicks READ lastGenerationTicks NOTIFY lastGenerationTicksChanged)
     Q_PROPERTY(uint lastGenerationFoodLeft READ lastGenerationFoodLeft NOTIFY lastGenerationFoodLeftChanged)
     Q_PROPERTY(uint lastGenerationMaxEnergy READ lastGenerationMaxEnergy NOTIFY lastGenerationMaxEnergyChanged)
+    Q_PROPERTY(uint genomes READ genomes NOTIFY genomesChanged)
+    Q_PROPERTY(uint lastGenerationAllocations READ lastGenerationAllocations NOTIFY lastGenerationAllocationsChanged)
+    Q_PROPERTY(uint lastGenerationAllocatedBytes READ lastGenerationAllocatedBytes NOTIFY lastGenerationAllocatedBytesChanged)
     Q_PROPERTY(QObject *league READ league NOTIFY leagueChanged)
     Q_PROPERTY(QObject *history READ history NOTIFY historyChanged)
+    Q_PROPERTY(QObject *memoryUsage READ memoryUsage CONSTANT)
 
 public:
     explicit WormTank(QObject *parent = 0);
     ~WormTank();
 
+    /**
+     * @brief Working storage for the sensors
+     *
+     * Each thread planning moves has its own, the tank's own is used
+     * when there are no tiles.
+     */
+    struct SensorScratch
+    {
+        SensorScratch() : nextToVersion(0), nextToDir(0) {}
+
+        std::vector<QPoint> pointsInRange; // Found by foodInRange and wormsInRange, kept to save allocating it each time
+        uint nextToVersion;
+        QPoint nextToPt;
+        int nextToDir;
+        int nextToCells[3];
+    };
+    static void setThreadScratch(SensorScratch *scratch) {s_threadScratch = scratch;}
+
 	void start(QString wormType, bool reset);
 	void startBattle(QString wormType1, QString wormType2, bool reset);
     void startLeague();
@@ -57,6 +88,14 @@ public:
     bool loadArena();
     void reset(QString wormType);
 
+    TankSettings settings() const;
+    void setSettings(const TankSettings &settings);
+    /**
+     * @brief Settings used the next time a training tank is reset
+     */
+    const TankSettings &newTankSettings() const {return m_newTankSettings;}
+    void setNewTankSettings(const TankSettings &settings);
+
     void save();
 
     QString name() const {return m_name;}
@@ -73,6 +112,9 @@ public:
 
     QObject *league();
     QObject *history();
+    QObject *memoryUsage();
+    const MemoryUsage &memoryFigures() const {return m_memoryUsage;}
+    void measureMemory();
     uint latestGeneration(QString wormType);
 
     // Stats from last generation
@@ -82,28 +124,60 @@ public:
     uint lastGenerationFoodLeft() const;
     uint lastGenerationMaxEnergy() const;
 
+    /**
+     * @brief Number of different brains in the current generation
+     */
+    uint genomes() const {return m_genomes;}
+
+    /**
+     * @brief Number of allocations for worms, their bodies and their brains'
+     * storage made running the last generation and creating the current one
+     */
+    uint lastGenerationAllocations() const {return m_lastGenerationAllocations;}
+    /**
+     * @brief Number of bytes in the allocations counted by lastGenerationAllocations
+     */
+    uint lastGenerationAllocatedBytes() const {return m_lastGenerationAllocatedBytes;}
+
     unsigned int maxDistance() const {return m_maxDistance;}
+    quint64 nextRandomSeed();
+    int width() const {return m_width;}
+    int height() const {return m_height;}
 
-    QImage tankImage() const {return m_tankImage;}
+    /**
+     * @brief Time taken by the brains to plan their moves
+     */
+    MoveCosts &moveCosts() {return m_moveCosts;}
+    const MoveCosts &moveCosts() const {return m_moveCosts;}
+
+    Worm *newWorm();
+    void recycleWorm(Worm *worm);
+
+    QImage tankImage(QSize size = QSize()) const {return m_grid.image(size, PositionColours, NUM_POSITIONS);}
     QColor colourForIndex(int index);
 
     // Sensors
-    void foodSeen(QPoint pt, int dir, InputBrainCell *inputs);
-    void wormSeen(QPoint pt, int dir, InputBrainCell *inputs);
-    void foodNextTo(QPoint pt, int dir, InputBrainCell *inputs);
-    void wormNextTo(QPoint pt, int dir, InputBrainCell *inputs);
-    void wallNextTo(QPoint pt, int dir, InputBrainCell *inputs);
+    void foodSeen(QPoint pt, int dir, int *inputs);
+    void wormSeen(QPoint pt, int dir, int *inputs);
+    void foodNextTo(QPoint pt, int dir, int *inputs);
+    void wormNextTo(QPoint pt, int dir, int *inputs);
+    void wallNextTo(QPoint pt, int dir, int *inputs);
+
+    void foodSeen(QPoint pt, int dir, const int *ranges, int numRanges, int *inputs);
+    void wormSeen(QPoint pt, int dir, const int *ranges, int numRanges, int *inputs);
+    void wallSeen(QPoint pt, int dir, const int *ranges, int numRanges, int *inputs);
 
-    void foodSeen(QPoint pt, int dir, int *ranges, int numRanges, InputBrainCell *inputs);
-    void wormSeen(QPoint pt, int dir, int *ranges, int numRanges, InputBrainCell *inputs);
-    void wallSeen(QPoint pt, int dir, int *ranges, int numRanges, InputBrainCell *inputs);
+    void foodCount(QPoint pt, int dir, const int *ranges, int numRanges, int *inputs);
+    void wormCount(QPoint pt, int dir, const int *ranges, int numRanges, int *inputs);
 
-    void foodCount(QPoint pt, int dir, int *ranges, int numRanges, InputBrainCell *inputs);
-    void wormCount(QPoint pt, int dir, int *ranges, int numRanges, InputBrainCell *inputs);
+    void foodBeam(QPoint pt, int dir, int *inputs);
+    void wormBeam(QPoint pt, int dir, int *inputs);
+    void wallBeam(QPoint pt, int dir, int *inputs);
 
-    void foodBeam(QPoint pt, int dir, InputBrainCell *inputs);
-    void wormBeam(QPoint pt, int dir, InputBrainCell *inputs);
-    void wallBeam(QPoint pt, int dir, InputBrainCell *inputs);
+    void foodNearest(QPoint pt, int dir, int *inputs);
+    void wormNearest(QPoint pt, int dir, int *inputs);
+
+    void foodGradient(QPoint pt, int dir, int *inputs);
 
     // Helpers
     /**
@@ -111,6 +185,20 @@ public:
      * @return true if point is in the tank
      */
     inline bool pointInTank(QPoint pt) const {return pt.x() >= 0 && pt.x() < m_width && pt.y() >= 0 && pt.y() < m_height;}
+    /**
+     * @brief Get the index of a cell in the tank grid
+     *
+     * Adding m_cellOffsets[dir] to an index moves one cell in that direction.
+     */
+    inline int cellIndex(QPoint pt) const {return m_grid.index(pt);}
+    /**
+     * @brief Get the colour of a cell from its index
+     */
+    inline int cellAt(int idx) const {return m_grid.at(idx);}
+    /**
+     * @brief Get the sensor working storage for the current thread
+     */
+    inline SensorScratch &sensorScratch() {return s_threadScratch ? *s_threadScratch : m_scratch;}
 
 protected:
 	void nextGeneration();
@@ -121,6 +209,7 @@ protected:
     void setMaxEnergy(unsigned int energy);
     void setLeaderAge(unsigned int age);
     void setLeaderAtTop(unsigned int atTop);
+    void setGenomes(uint genomes);
 
     void save(QString fileName);
     bool load(QString fileName);
@@ -133,12 +222,30 @@ protected:
 
     void setFirstGenerationVars();
     void newGeneration();
+    uint breedRound(uint numSurvivors, uint childrenLeft);
+    void addChild(Worm *worm, int chance, int weight);
+    uint countGenomes() const;
+    void removeEatenFood();
+    void removeDeadWorms(const std::vector<Worm *> &died);
+    void checkStagnation(bool quiet);
+    void resetStagnation();
+    bool checkCycles();
+    uint commonLoopPeriod() const;
+    void takeSnapshot();
+    bool repeatsSnapshot() const;
+    void fastForward();
+    void planMovesInTiles();
+    void planTileMoves(uint tile);
     void nextLeagueMatch();
 
-    void setFoundRanges(QPoint ptRelative, int dir, int *rangesSquared, int numRanges, InputBrainCell *inputs);
-    void setNotFoundRanges(int numRanges, InputBrainCell *inputs);
-    void countFoundRanges(QPoint ptRelative, int dir, int *rangesSquared, int numRanges, InputBrainCell *inputs);
+    void setFoundRanges(QPoint ptRelative, int dir, int *rangesSquared, int numRanges, int *inputs);
+    void setNotFoundRanges(int numRanges, int *inputs);
+    void countFoundRanges(QPoint ptRelative, int dir, int *rangesSquared, int numRanges, int *inputs);
+    int setupRanges(const int *ranges, int numRanges, int *rangesSquared, int *inputs) const;
+    const std::vector<QPoint> &foodInRange(QPoint pt, int maxRangeSquared);
+    const std::vector<QPoint> &wormsInRange(QPoint pt, int maxRangeSquared);
     int beam(QPoint pt, int dir) const;
+    void nearestInCones(const QuadTree &index, QPoint pt, int dir, int *inputs);
 
     QString latestFileName(QString wormName);
     QString battleFileName();
@@ -158,6 +265,9 @@ signals:
     void lastGenerationTicksChanged(uint ticks);
     void lastGenerationFoodLeftChanged(uint left);
     void lastGenerationMaxEnergyChanged(uint energy);
+    void genomesChanged(uint genomes);
+    void lastGenerationAllocationsChanged(uint allocations);
+    void lastGenerationAllocatedBytesChanged(uint bytes);
     void matchEnded();
     void leagueChanged();
     void leagueFinished();
@@ -168,6 +278,17 @@ public slots:
 
 protected:
 	QPoint getEmptyPos();
+    void setSize(int width, int height);
+    void setCell(QPoint pt, int colour);
+    /**
+     * @brief Get the state of a cell in the food distance field from its colour
+     */
+    static DistanceField::CellState distanceState(int colour)
+    {
+        if (colour == FOOD_COLOUR) return DistanceField::Source;
+        return (colour >= WORM_COLOUR) ? DistanceField::Blocked : DistanceField::Free;
+    }
+    const int *nextToCells(QPoint pt, int dir);
 
         void setupTank();
         
@@ -182,9 +303,85 @@ private:
     unsigned int m_startWorms;
     unsigned int m_foodEnergy;
     unsigned int m_survivors;
-    QImage m_tankImage;
+    int m_tileSize;
+    uint m_stagnantTicks;
+    unsigned int m_trainingSurvivors; // Survivors kept when not in a battle, arena or league
+    TankSettings m_newTankSettings;
+    TankGrid m_grid;
+    int m_cellOffsets[4]; // Index change to move one cell in each direction
     std::vector<QPoint> m_food;
+    uint m_foodEaten; // Food eaten this step that is still in m_food
+    bool m_ateThisStep; // A worm ate this step, whether or not the food has been taken out of m_food yet
     std::vector<Worm *> m_worms;
+    std::vector<Worm *> m_spareWorms; // Worms that have been thrown away, kept to make new ones from
+    QuadTree m_foodIndex;
+    QuadTree m_wormIndex;
+    DistanceField m_foodDistance;
+    uint m_cellVersion;
+    quint64 m_randomSeeds; // Seeds handed out by nextRandomSeed
+    SensorScratch m_scratch;
+    static thread_local SensorScratch *s_threadScratch; // Set while a thread is planning the moves of a tile
+
+    /**
+     * @brief Move planned by a worm before any worm moves
+     */
+    struct PlannedMove
+    {
+        QPoint pt;
+        int dir;
+        quint64 nsecs;
+    };
+    TankTiles m_tiles;
+    std::vector<PlannedMove> m_plannedMoves; // One for each worm in m_worms
+    std::vector<SensorScratch> m_plannerScratch; // One for each planning thread
+    QThreadPool m_plannerPool;
+    friend class TilePlanner; // Calls planTileMoves on the pool threads
+    QMutex m_foodDistanceMutex; // Held while the food distance field is first built
+
+    /**
+     * @brief Search for a worm going round the same loop
+     *
+     * Heads and directions are compared with the one at the start of a
+     * window which doubles in length until a match is found. The loop
+     * is only trusted once two in a row have the same length, the same
+     * rolling hash of the heads and directions and use the same energy.
+     */
+    struct CycleCheck
+    {
+        quint64 start;          // Head and direction at the start of the window
+        quint64 pathHash;       // Rolling hash of the heads and directions since the start
+        quint64 lastPathHash;   // Path hash of the last loop found
+        uint startTick;
+        uint startEnergy;
+        uint window;            // Ticks to look for the start again before starting over
+        uint period;            // Ticks in the last loop found, 0 for none
+        uint drain;             // Energy used going round the last loop
+        bool cycling;           // The last two loops were the same
+    };
+    std::vector<CycleCheck> m_cycleChecks; // One for each worm in m_worms once the tank is stagnant
+    uint m_quietTicks; // Ticks since food was eaten or a worm died
+
+    /**
+     * @brief A worm as it was at the start of the common loop being checked
+     */
+    struct WormSnapshot
+    {
+        WormBody body;
+        int dir;
+        uint energy;
+    };
+    std::vector<WormSnapshot> m_snapshot; // One for each worm in m_worms while m_loopPeriod is set
+    uint m_loopPeriod;      // Ticks for all the worms to go round their loops together, 0 while searching
+    uint m_snapshotTick;
+    bool m_loopRepeated;    // The last check found the tank back as it was
+    static const uint MinCycleWindow = 4;
+    static const uint MaxCycleWindow = 4096;
+    static const int MaxCloneMutations = 3;
+    uint m_genomes;
+    uint m_lastGenerationAllocations;
+    uint m_lastGenerationAllocatedBytes;
+    MoveCosts m_moveCosts;
+    std::unordered_set<quint64> m_generationGenomes; // Brains already in the generation being created
     unsigned int m_wormsLeft;
     unsigned int m_foodLeft;
     unsigned int m_maxEnergy;
@@ -193,6 +390,7 @@ private:
     uint m_leaderAtTop;
     League *m_league;
     History m_history;
+    MemoryUsage m_memoryUsage;
 };
 
 /**
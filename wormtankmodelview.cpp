@@ -13,6 +13,7 @@ WormTankModelView::WormTankModelView(WormTank &wormTank, QObject *parent) :
     m_leagueView(nullptr),
     m_historyView(nullptr),
     m_generationView(nullptr),
+    m_memoryView(nullptr),
     m_wormList(nullptr),
     m_generationList(nullptr),
     m_finishedText(""),
@@ -27,6 +28,7 @@ WormTankModelView::~WormTankModelView()
     delete m_leagueView;
     delete m_historyView;
     delete m_generationView;
+    delete m_memoryView;
     if (m_wormList)
     {
         for (auto wc : *m_wormList)
@@ -121,6 +123,24 @@ void WormTankModelView::start(QString wormType, bool reset)
     startRun();
 }
 
+/**
+ * @brief Set the size and population used when a training tank is reset
+ *
+ * A tank loaded from its save file keeps the settings it was started with.
+ */
+void WormTankModelView::setNewTankSettings(int width, int height, int worms, int food, int survivors, int tileSize, int stagnantTicks)
+{
+    TankSettings settings;
+    settings.width = width;
+    settings.height = height;
+    settings.startWorms = uint(worms);
+    settings.startFood = uint(food);
+    settings.survivors = uint(survivors);
+    settings.tileSize = tileSize;
+    settings.stagnantTicks = uint(stagnantTicks);
+    m_wormTank.setNewTankSettings(settings);
+}
+
 /**
 * @brief Show dialog to choose worm type and start the tank running
 */
@@ -459,6 +479,13 @@ void WormTankModelView::updateWormList()
         } else delPos++;
 	}
 
+    for (auto item : *m_wormList)
+    {
+        WormCount *wormCount = static_cast<WormCount *>(item);
+        const MoveCost *cost = m_wormTank.moveCosts().lastCost(wormCount->name().toStdString());
+        if (cost) wormCount->setMoveTimes(cost->meanNsecs() / 1000.0, cost->percentile(99) / 1000.0);
+    }
+
     if (resetList)
     {
         // Reset context if number of items in the list changed
@@ -543,6 +570,25 @@ void WormTankModelView::viewGeneration()
     m_generationView->show();
 }
 
+/**
+ * @brief View the memory used by each part of the tank
+ */
+void WormTankModelView::viewMemory()
+{
+    if (!m_memoryView)
+    {
+        m_memoryView = new QQuickView();
+        m_memoryView->setSource(QUrl("qrc:/MemoryView.qml"));
+        QQmlContext *ctx = m_memoryView->rootContext();
+        ctx->setContextProperty("wormTankModelView", this);
+        ctx->setContextProperty("wormTank", &m_wormTank);
+
+        m_memoryView->setTitle("WormTank - Memory");
+        m_memoryView->setResizeMode(QQuickView::SizeRootObjectToView);
+    }
+    m_memoryView->show();
+}
+
 /**
  * @brief Update the generation list when running in standard mode
  * @param generation new generation
@@ -553,4 +599,5 @@ void WormTankModelView::updateGenerationList(uint generation)
     {
         m_generationList->updateGeneration(m_wormTank.name(), generation);
     }
+    m_generationList->updateCosts(m_wormTank.moveCosts());
 }
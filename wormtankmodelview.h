@@ -43,6 +43,7 @@ signals:
 
 public slots:
     void start(QString wormType, bool reset);
+    void setNewTankSettings(int width, int height, int worms, int food, int survivors, int tileSize, int stagnantTicks);
 	void startBattle(QString wormType1, QString wormType2, bool reset);
     void startLeague();
     void startArena();
@@ -59,6 +60,7 @@ public slots:
     void viewLeague();
     void viewHistory();
     void viewGeneration();
+    void viewMemory();
 
     void updateGenerationList(uint generation);
 
@@ -74,6 +76,7 @@ protected:
     QQuickView *m_leagueView;
     QQuickView *m_historyView;
     QQuickView *m_generationView;
+    QQuickView *m_memoryView;
     QList<QObject *> *m_wormList;
     GenList *m_generationList;
     QString m_finishedText;